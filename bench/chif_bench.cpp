@@ -0,0 +1,807 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  chif_bench
+*     Drive the CHIF handlers in isolation and report ns/op and allocs/op.
+*
+*     chif_bench [-t MS] [-k] [-dbp] [FILTER]
+*        -t MS   time spent on each case (default 200)
+*        -k      keep the scratch directory
+*        -dbp    handler debug output (handler output is discarded otherwise)
+*        FILTER  only run the cases whose name contains FILTER
+*
+*     All state files live under a scratch directory passed to the handlers
+*     as $CHIF_ROOT, and gChifOffline keeps systemd and D-Bus out of it.
+*     Every registered SMIF command runs through ChifHandler(); the SMBIOS
+*     download, EV, PlatDef, event decoder and SMBIOS lookup paths are also
+*     timed directly.  I2C goes to the simulated buses of i2c_sim.hpp.
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <vector>
+#include <string>
+
+#include "zlib.h"
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "stats.hpp"
+#include "smif.hpp"
+#include "ev.hpp"
+#include "platdef_api.hpp"
+#include "uefi.hpp"
+#include "i2c_mapping.hpp"
+#include "i2c_xfer.hpp"
+#include "i2c_sim.hpp"
+#include "i2c_cache.hpp"
+#include "gpio_regs.hpp"
+#include "reactor.hpp"
+#include "smbios.hpp"
+#include "cfg_smbios.hpp"
+#include "DataExtract.h"
+#include "logs.h"
+#include "misc.hpp"
+
+extern bool gdbPrint;
+extern int smbios_get_module(UINT8 matchtype, int num, type_dimm *composite);
+
+#define BENCH_EVS           32
+#define BENCH_EV_SIZE       64
+#define BENCH_CPUS          2
+#define BENCH_DIMMS         16
+#define BENCH_SMBIOS_FILL   160     // slots, bridges, versions... around a real table
+#define BENCH_PLATDEF_RECS  200
+
+/*
+ * Allocation counting.  glibc lets a program replace malloc(); operator new
+ * in libstdc++ ends up here as well.
+ */
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+static uint64_t bench_allocs;
+
+extern "C" void *malloc(size_t size)
+{
+    bench_allocs++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+    bench_allocs++;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+    bench_allocs++;
+    return __libc_realloc(p, size);
+}
+
+static FILE *out;
+static const char *filter;
+static uint64_t target_ns = 200 * 1000000ull;
+static char root[] = "/tmp/chif_bench.XXXXXX";
+
+static uint8_t recv_buf[CHIF_PKT_MAX_SIZE], resp_buf[CHIF_PKT_MAX_SIZE];
+
+/* bench()
+ *
+ * Time op() until target_ns has been spent in it.  setup() runs untimed
+ * before every 'batch' calls of op(), for cases that consume state.
+ */
+template <typename Setup, typename Op>
+static void bench(const char *name, int batch, Setup setup, Op op)
+{
+    uint64_t ns = 0, allocs = 0, ops = 0, t0, a0;
+    int i;
+
+    if (filter && !strstr(name, filter))
+        return;
+
+    setup();
+    op();       // first call: path lookups, lazy init, page cache
+
+    while (ns < target_ns) {
+        setup();
+        a0 = bench_allocs;
+        t0 = stats_now_ns();
+        for (i = 0; i < batch; i++)
+            op();
+        ns += stats_now_ns() - t0;
+        allocs += bench_allocs - a0;
+        ops += batch;
+    }
+
+    fflush(stdout);
+    fprintf(out, "%-56s %12.0f ns/op %8.1f allocs/op %10llu ops\n", name,
+            (double)ns / ops, (double)allocs / ops, (unsigned long long)ops);
+    fflush(out);
+}
+
+template <typename Op>
+static void bench(const char *name, Op op)
+{
+    bench(name, 64, [] {}, op);
+}
+
+/* request in recv_buf */
+static void chif_request(uint8_t service_id, uint16_t command, const void *msg, uint16_t len)
+{
+    struct ChifPkt *pkt = (struct ChifPkt *)recv_buf;
+
+    memset(recv_buf, 0, sizeof(recv_buf));
+    pkt->header.pkt_size = sizeof(struct ChifPktHeader) + len;
+    pkt->header.sequence = 0x1234;
+    pkt->header.command = command;
+    pkt->header.service_id = service_id;
+    if (len)
+        memcpy(pkt->msg, msg, len);
+}
+
+static int chif_call(void)
+{
+    return ChifHandler(recv_buf, resp_buf, CHIF_PKT_MAX_SIZE);
+}
+
+static void mkdirs(const char *path)
+{
+    std::string p = std::string(root) + path;
+    size_t i;
+
+    for (i = 1; i <= p.size(); i++) {
+        if (i == p.size() || p[i] == '/')
+            mkdir(p.substr(0, i).c_str(), 0755);
+    }
+}
+
+static int rm_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+/*
+ * SMIF: host side layout of the requests that carry a payload
+ */
+struct bench_0072 {
+    uint32_t reserved;
+    uint8_t magic[8];
+    uint16_t address;
+    uint8_t segment;
+    uint8_t write_len;
+    uint8_t read_len;
+    uint8_t data[32];
+} __attribute__ ((packed));
+
+struct bench_007a {
+    uint32_t reserved;
+    uint8_t magic[8];
+    uint8_t segment;
+    uint8_t flags;
+    uint8_t count;
+    uint8_t reserved2;
+    uint8_t txn[16][4];
+} __attribute__ ((packed));
+
+struct bench_0088 {
+    uint32_t operation;
+    uint32_t index;
+    uint32_t reserved1;
+    uint32_t status;
+    uint8_t val;
+} __attribute__ ((packed));
+
+struct bench_012c {
+    uint8_t flags;
+    uint8_t rsvd[3];
+    char name[EV_NAME_MAX_LEN];
+    uint16_t sz_ev;
+    uint8_t buf[BENCH_EV_SIZE];
+} __attribute__ ((packed));
+
+struct bench_0146 {
+    uint8_t evtType;
+    uint16_t matchCode;
+    uint16_t evtClass;
+    uint16_t evtCode;
+    uint8_t severity;
+    uint16_t evtVarLen;
+    uint8_t buf[32];
+} __attribute__ ((packed));
+
+static uint16_t smif_payload(uint16_t command, uint16_t req_size, uint8_t *msg)
+{
+    memset(msg, 0, CHIF_PKT_MAX_SIZE - sizeof(struct ChifPktHeader));
+
+    switch (command) {
+    case 0x0072: {      // read 2 bytes from a DIMM SPD on segment 0
+        struct bench_0072 *m = (struct bench_0072 *)msg;
+        m->address = 0xa0;
+        m->write_len = 1;
+        m->read_len = 2;
+        return sizeof(*m);
+    }
+    case 0x007a: {      // the 512 byte SPD on segment 0 in 32 byte reads
+        struct bench_007a *m = (struct bench_007a *)msg;
+        m->count = 16;
+        for (int i = 0; i < 16; i++) {
+            m->txn[i][0] = 0xa0;
+            m->txn[i][1] = 1;
+            m->txn[i][2] = 32;
+            m->txn[i][3] = i * 32;
+        }
+        return sizeof(*m);
+    }
+    case 0x0088: {      // read the low byte of the CPLD server ID
+        struct bench_0088 *m = (struct bench_0088 *)msg;
+        m->operation = 3;
+        m->index = 1;
+        return sizeof(*m);
+    }
+    case 0x012b:        // EV by index
+        msg[0] = BENCH_EVS / 2;
+        return 4;
+    case 0x012c: {      // rewrite an existing EV, same size
+        struct bench_012c *m = (struct bench_012c *)msg;
+        m->flags = 0x01;
+        snprintf(m->name, sizeof(m->name), "BENCH_EV_%02d", BENCH_EVS / 2);
+        m->sz_ev = BENCH_EV_SIZE;
+        memset(m->buf, 0x5a, sizeof(m->buf));
+        return sizeof(*m);
+    }
+    case 0x0130:        // EV by name
+        snprintf((char *)msg, EV_NAME_MAX_LEN, "BENCH_EV_%02d", BENCH_EVS / 2);
+        return EV_NAME_MAX_LEN;
+    case 0x0143:        // POST state
+        msg[0] = 1;
+        return 4;
+    case 0x0146: {      // IML overheat event with its variable data
+        struct bench_0146 *m = (struct bench_0146 *)msg;
+        m->evtType = 0x01;
+        m->evtClass = EVT_CLASS_MACHINE_ENV;
+        m->evtCode = EVT_MACHINE_OVERHEAT;
+        m->severity = EVT_CAUTION;
+        m->evtVarLen = sizeof(m->buf);
+        for (size_t i = 0; i < sizeof(m->buf); i++)
+            m->buf[i] = i;
+        return sizeof(*m);
+    }
+    case 0x0209:        // boot progress
+        msg[0] = 0x01;
+        return 8;
+    }
+    return req_size;
+}
+
+static void bench_smif(void)
+{
+    static uint8_t msg[CHIF_PKT_MAX_SIZE];
+    const struct chif_service *svc = &smif_service;
+    char name[128];
+    uint16_t k, len;
+
+    for (k = 0; k < svc->span; k++) {
+        const struct chif_cmd *cmd;
+
+        if (!svc->index[k])
+            continue;
+        cmd = &svc->cmds[svc->index[k] - 1];
+
+        snprintf(name, sizeof(name), "smif 0x%04x %s", cmd->command, cmd->name);
+        len = smif_payload(cmd->command, cmd->req_size, msg);
+        bench(name, 64, [&] { chif_request(0, cmd->command, msg, len); }, chif_call);
+    }
+}
+
+/*
+ * I2C through SMIF 0x0072 on the simulated buses, segment 0 is bus 5
+ */
+static void bench_i2c(void)
+{
+    static uint8_t msg[CHIF_PKT_MAX_SIZE];
+    struct bench_0072 *m = (struct bench_0072 *)msg;
+    uint16_t len = smif_payload(0x0072, 0, msg);
+    auto request = [&] { chif_request(0, 0x0072, msg, len); };
+
+    // SPD on a 100 kHz bus, about 90 us a byte
+    i2c_sim_add("5 0x51 size=512 byte=90");
+    m->address = 0x51 << 1;
+    m->read_len = 16;
+    bench("i2c sim 0x0072 SPD read 16 bytes 100kHz", 16, request, chif_call);
+
+    i2c_cache_allow(0, 0x51, I2C_CACHE_EEPROM);
+    i2c_cache_enable(60000);
+    bench("i2c sim 0x0072 SPD read 16 bytes 100kHz cached", 16, request, chif_call);
+    i2c_cache_enable(0);
+
+    // empty DIMM slot, NACK after the address byte
+    i2c_sim_add("5 0x52 nak=100 byte=90");
+    m->address = 0x52 << 1;
+    bench("i2c sim 0x0072 empty slot", 16, request, chif_call);
+}
+
+/*
+ * SMBIOS download (ROM 0x03 begin, 0x04 record, 0x0c blob, 0x05 end)
+ */
+static std::vector<std::vector<uint8_t>> smbios_recs;
+
+static void smbios_add(const void *rec, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)rec;
+    std::vector<uint8_t> r(p, p + len);
+
+    // empty string set
+    r.push_back(0);
+    r.push_back(0);
+    smbios_recs.push_back(r);
+}
+
+/* two sockets, 16 DIMMs with their location and I2C map records, and filler */
+static void smbios_table(void)
+{
+    uint16_t handle = 0x100;
+    int i;
+
+    for (i = 0; i < BENCH_CPUS; i++) {
+        type_4 r4;
+        type_197 r197;
+
+        memset(&r4, 0, sizeof(r4));
+        r4.hdr.type = 4;
+        r4.hdr.len = sizeof(r4);
+        r4.hdr.handle = 0x400 + i;
+        r4.cpu_status = 0x41;
+        smbios_add(&r4, sizeof(r4));
+
+        memset(&r197, 0, sizeof(r197));
+        r197.hdr.type = SMBIOS_TYPE_CPQ_PROC;
+        r197.hdr.len = sizeof(r197);
+        r197.hdr.handle = handle++;
+        r197.hndl_type_4 = 0x400 + i;
+        r197.slot = i + 1;
+        r197.socket = i + 1;
+        smbios_add(&r197, sizeof(r197));
+    }
+
+    for (i = 0; i < BENCH_DIMMS; i++) {
+        type_17 r17;
+        type_202 r202;
+        type_227 r227;
+
+        memset(&r17, 0, sizeof(r17));
+        r17.hdr.type = 17;
+        r17.hdr.len = sizeof(r17);
+        r17.hdr.handle = 0x1100 + i;
+        r17.size = 0x7fff;
+        r17.extended_size = 32768;
+        r17.set = i / 8 + 1;
+        r17.type = 0x22;
+        smbios_add(&r17, sizeof(r17));
+
+        memset(&r202, 0, sizeof(r202));
+        r202.hdr.type = SMBIOS_TYPE_MEM_LOC;
+        r202.hdr.len = sizeof(r202);
+        r202.hdr.handle = handle++;
+        r202.hndl_module = 0x1100 + i;
+        r202.slot = i % 8 + 1;
+        r202.socket = i / 8 + 1;
+        r202.ie_dimm = 0xff;
+        r202.ie_sensor = 0xff;
+        r202.dimm_index = i;
+        smbios_add(&r202, sizeof(r202));
+
+        memset(&r227, 0, sizeof(r227));
+        r227.hdr.type = SMBIOS_TYPE_DIMM_I2C;
+        r227.hdr.len = sizeof(r227);
+        r227.hdr.handle = handle++;
+        r227.hndl_type_4 = 0x400 + i / 8;
+        r227.hndl_type_17 = 0x1100 + i;
+        r227.seg = i / 8;
+        r227.addr = 0xa0 + (i % 8) * 2;
+        r227.type = SMBIOS_T227_MCP98242;
+        r227.bus = 0xff;
+        r227.dfn = 0xff;
+        r227.reg = 0xffff;
+        smbios_add(&r227, sizeof(r227));
+    }
+
+    for (i = 0; i < BENCH_SMBIOS_FILL; i++) {
+        uint8_t r[24];
+
+        memset(r, 0, sizeof(r));
+        r[0] = (i & 1) ? 9 : 216;
+        r[1] = sizeof(r);
+        *(uint16_t *)&r[2] = handle++;
+        smbios_add(r, sizeof(r));
+    }
+}
+
+/* as many records as fit in one packet, starting at rec; returns the next one */
+static size_t smbios_packet(size_t rec, size_t max_recs, uint8_t *msg, uint16_t *len)
+{
+    size_t off = sizeof(uint32_t);
+    uint32_t n = 0;
+
+    while (rec < smbios_recs.size() && n < max_recs &&
+           off + 2 + smbios_recs[rec].size() <= CHIF_PKT_MAX_SIZE - sizeof(struct ChifPktHeader)) {
+        *(uint16_t *)&msg[off] = smbios_recs[rec].size();
+        off += 2;
+        memcpy(&msg[off], smbios_recs[rec].data(), smbios_recs[rec].size());
+        off += smbios_recs[rec].size();
+        rec++;
+        n++;
+    }
+    *(uint32_t *)msg = n;
+    *len = off;
+    return rec;
+}
+
+static void smbios_begin(void)
+{
+    chif_request(ROM_SERVICE_ID, 0x03, NULL, 0);
+    chif_call();
+}
+
+static void smbios_blobs(void)
+{
+    static uint8_t msg[CHIF_PKT_MAX_SIZE];
+    size_t rec = 0;
+    uint16_t len;
+
+    while (rec < smbios_recs.size()) {
+        rec = smbios_packet(rec, smbios_recs.size(), msg, &len);
+        chif_request(ROM_SERVICE_ID, 0x0c, msg, len);
+        chif_call();
+    }
+}
+
+static void smbios_end(void)
+{
+    chif_request(ROM_SERVICE_ID, 0x05, NULL, 0);
+    chif_call();
+}
+
+static void bench_smbios(void)
+{
+    static uint8_t rec_msg[CHIF_PKT_MAX_SIZE], blob_msg[CHIF_PKT_MAX_SIZE];
+    uint16_t rec_len, blob_len;
+    size_t nblob;
+    type_dimm dimm;
+
+    smbios_table();
+    smbios_packet(BENCH_CPUS * 2, 1, rec_msg, &rec_len);
+    nblob = smbios_packet(0, smbios_recs.size(), blob_msg, &blob_len);
+
+    bench("rom 0x03 SMBIOS begin", smbios_begin);
+
+    bench("rom 0x04 SMBIOS record (type 17)", 64, smbios_begin, [&] {
+        chif_request(ROM_SERVICE_ID, 0x04, rec_msg, rec_len);
+        chif_call();
+    });
+
+    char name[64];
+    snprintf(name, sizeof(name), "rom 0x0c SMBIOS blob (%zu records)", nblob);
+    bench(name, 4, smbios_begin, [&] {
+        chif_request(ROM_SERVICE_ID, 0x0c, blob_msg, blob_len);
+        chif_call();
+    });
+
+    snprintf(name, sizeof(name), "rom 0x05 SMBIOS end (%zu records)", smbios_recs.size());
+    bench(name, 1, [] { smbios_begin(); smbios_blobs(); }, smbios_end);
+
+    // load a complete table for smbios_get_module(), like "chif smbios"
+    smbios_begin();
+    smbios_blobs();
+    smbios_end();
+    smbios_cfg_read_into_globalvar();
+    if (smbios_get_module(SMBIOS_T227_MCP98242, 0, &dimm) != SMBIOS_RETV_SUCCESS)
+        fprintf(out, "warning: SMBIOS download did not produce DIMM records\n");
+
+    bench("smbios_get_module first DIMM", [&] {
+        smbios_get_module(SMBIOS_T227_MCP98242, 0, &dimm);
+    });
+    bench("smbios_get_module last DIMM", [&] {
+        smbios_get_module(SMBIOS_T227_MCP98242, BENCH_DIMMS - 1, &dimm);
+    });
+    bench("smbios_get_module missing", [&] {
+        smbios_get_module(SMBIOS_T227_MCP98242, BENCH_DIMMS, &dimm);
+    });
+}
+
+/*
+ * EVs
+ */
+static void ev_setup(void)
+{
+    char name[EV_NAME_MAX_LEN], data[BENCH_EV_SIZE];
+    int i;
+
+    initEV();
+    memset(data, 0xa5, sizeof(data));
+    for (i = 0; i < BENCH_EVS; i++) {
+        snprintf(name, sizeof(name), "BENCH_EV_%02d", i);
+        setEV(name, data, sizeof(data));
+    }
+}
+
+/* write data to path under root, opened with O_CREAT and flags */
+static void ev_file(const char *path, const void *data, size_t len, int flags)
+{
+    int fd = open((std::string(root) + path).c_str(), O_WRONLY | O_CREAT | flags, 0644);
+
+    if (fd < 0)
+        return;
+    if (write(fd, data, len) != (ssize_t)len)
+        perror("chif_bench: write");
+    close(fd);
+}
+
+static void bench_ev(void)
+{
+    char first[EV_NAME_MAX_LEN], last[EV_NAME_MAX_LEN], missing[EV_NAME_MAX_LEN];
+    char data[EV_MAX_LEN];
+
+    snprintf(first, sizeof(first), "BENCH_EV_%02d", 0);
+    snprintf(last, sizeof(last), "BENCH_EV_%02d", BENCH_EVS - 1);
+    snprintf(missing, sizeof(missing), "BENCH_NO_SUCH_EV");
+
+    bench("getEVbyName first", [&] { getEVbyName(first, data, sizeof(data)); });
+    bench("getEVbyName last", [&] { getEVbyName(last, data, sizeof(data)); });
+    bench("getEVbyName missing", [&] { getEVbyName(missing, data, sizeof(data)); });
+    bench("getEVbyIndex last", [&] { getEVbyIndex(BENCH_EVS - 1, data, sizeof(data)); });
+
+    memset(data, 0x3c, BENCH_EV_SIZE);
+    bench("setEV rewrite, same size", [&] { setEV(last, data, BENCH_EV_SIZE); });
+    flushEV();
+    setEVCommitWindow(0);
+    bench("setEV rewrite, synced", [&] { setEV(last, data, BENCH_EV_SIZE); });
+    setEVCommitWindow(EV_COMMIT_MS);
+
+    // startup: the log the cases above left, the same with a record torn by
+    // a crash at its end, and the evs.tmp the old rewrite left without an
+    // evs.dat, which is converted.  The log is closed untimed, so only the
+    // recovery and the scan are measured
+    std::vector<uint8_t> torn(sizeof(struct ev_rec) + BENCH_EV_SIZE / 2, 0x5a);
+    std::vector<uint8_t> legacy;
+    struct ev le;
+    int i;
+
+    for (i = 0; i < BENCH_EVS; i++) {
+        memset(&le, 0, sizeof(le));
+        le.size = BENCH_EV_SIZE;
+        snprintf(le.name, sizeof(le.name), "BENCH_EV_%02d", i);
+        legacy.insert(legacy.end(), (uint8_t *)&le, (uint8_t *)&le + sizeof(le));
+        legacy.insert(legacy.end(), BENCH_EV_SIZE, 0xa5);
+    }
+
+    bench("initEV", 1, [] { closeEV(); }, [] { initEV(); });
+    bench("initEV, torn record at the end", 1,
+          [&] {
+              closeEV();
+              ev_file("/home/root/evs.dat", torn.data(), torn.size(), O_APPEND);
+          },
+          [] { initEV(); });
+    bench("initEV, evs.tmp of the old rewrite", 1,
+          [&] {
+              closeEV();
+              unlink((std::string(root) + "/home/root/evs.dat").c_str());
+              ev_file("/home/root/evs.tmp", legacy.data(), legacy.size(), O_TRUNC);
+          },
+          [] { initEV(); });
+}
+
+/*
+ * PlatDef: a zlib compressed table of temperature sensors
+ */
+static int platdef_file(void)
+{
+    std::vector<uint8_t> blob, comp;
+    PlatDefTableData td;
+    PlatDefRecordHeader hdr;
+    uLongf comp_len;
+    std::string path = std::string(root) + PLATDEF_DATA_FILE;
+    FILE *fp;
+    int i;
+
+    for (i = 0; i < BENCH_PLATDEF_RECS; i++) {
+        uint8_t rec[256];
+
+        memset(rec, 0, sizeof(rec));
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.Type = RecordType_TempSensor;
+        hdr.Size = sizeof(rec) / 16;
+        hdr.RecordID = i + 2;
+        snprintf(hdr.Name, sizeof(hdr.Name), "Temp %d", i);
+        memcpy(rec, &hdr, sizeof(hdr));
+        blob.insert(blob.end(), rec, rec + sizeof(rec));
+    }
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.Type = RecordType_EndOfTable;
+    hdr.Size = sizeof(hdr) / 16;
+    blob.insert(blob.end(), (uint8_t *)&hdr, (uint8_t *)&hdr + sizeof(hdr));
+
+    comp_len = compressBound(blob.size());
+    comp.resize(comp_len);
+    if (compress(comp.data(), &comp_len, blob.data(), blob.size()) != Z_OK)
+        return -1;
+
+    memset(&td, 0, sizeof(td));
+    td.Header.Type = RecordType_TableData;
+    td.Header.Size = (sizeof(td) + 15) / 16;
+    td.Header.RecordID = 1;
+    snprintf(td.Description, sizeof(td.Description), "chif_bench");
+    td.Flags = TableFlag_ZLib;
+    td.RecordCount = BENCH_PLATDEF_RECS + 2;
+    td.TotalSize = sizeof(td) + blob.size();
+    td.CompressedSize = sizeof(td) + comp_len;
+
+    fp = fopen(path.c_str(), "wb");
+    if (!fp)
+        return -1;
+    fwrite(&td, sizeof(td), 1, fp);
+    fwrite(comp.data(), comp_len, 1, fp);
+    fclose(fp);
+    return 0;
+}
+
+static void bench_platdef(void)
+{
+    static UINT8 resp[PLATDEF_CHUNK_SIZE];
+    PlatDefDataRequest req[16];
+    UINT32 size, token;
+    UINT16 count;
+    int i;
+
+    // spread over the table, the lookup walks it from the start
+    for (i = 0; i < 16; i++) {
+        req[i].RecordID = 2 + i * (BENCH_PLATDEF_RECS / 16);
+        req[i].Offset = 0;
+        req[i].length = 64;
+    }
+
+    bench("platdef_Download_specific_data 16 x 64 bytes", [&] {
+        size = sizeof(resp);
+        count = 16;
+        platdef_Download_specific_data(&size, 0, &count, req, resp, sizeof(resp), &token);
+    });
+}
+
+/*
+ * Event decoder
+ */
+static void bench_decode(void)
+{
+    EVT_LOG_ENTRY evt;
+    char text[512];
+    size_t i;
+
+    memset(&evt, 0, sizeof(evt));
+    for (i = 0; i < sizeof(evt.data); i++)
+        ((uint8_t *)&evt.data)[i] = i;
+
+    evt.hdr.evtClass = EVT_CLASS_MACHINE_ENV;
+    evt.hdr.evtCode = EVT_MACHINE_OVERHEAT;
+    bench("decode_text IML overheat", [&] {
+        decode_text(LOGS_IMLDATA, &evt, text, sizeof(text), TEXT_DESC);
+    });
+    bench("decode_text IML overheat action", [&] {
+        decode_text(LOGS_IMLDATA, &evt, text, sizeof(text), TEXT_ACTION);
+    });
+
+    evt.hdr.evtClass = 0xffff;
+    evt.hdr.evtCode = 0xffff;
+    bench("decode_text unknown event", [&] {
+        decode_text(LOGS_IMLDATA, &evt, text, sizeof(text), TEXT_DESC);
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    bool keep = false;
+    int i, fd;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            target_ns = strtoull(argv[++i], NULL, 0) * 1000000ull;
+        else if (strcmp(argv[i], "-k") == 0)
+            keep = true;
+        else if (strcmp(argv[i], "-dbp") == 0)
+            gdbPrint = true;
+        else if (argv[i][0] != '-' && !filter)
+            filter = argv[i];
+        else {
+            printf("usage: %s [-t MS] [-k] [-dbp] [FILTER]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!mkdtemp(root)) {
+        perror("chif_bench: mkdtemp");
+        return 1;
+    }
+    setenv("CHIF_ROOT", root, 1);
+    gChifOffline = true;
+    mkdirs("/home/root");
+    mkdirs("/var/lib/smbios");
+    mkdirs("/tmp/ubm");
+    mkdirs("/sys/class/soc/xreg");
+
+    // handlers print errors on stdout, helpers they run on stderr
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    if (!gdbPrint) {
+        fd = open("/dev/null", O_WRONLY);
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+    }
+    fprintf(out, "chif_bench: state under %s, %llu ms per case\n", root,
+            (unsigned long long)(target_ns / 1000000));
+
+    // segment 0 reachable on bus 5
+    FILE *fp = fopen((std::string(root) + I2C_MAPPING).c_str(), "w");
+    if (fp) {
+        fprintf(fp, "0 0 5\n");
+        fclose(fp);
+    }
+    fp = fopen((std::string(root) + GPIO_XREG_SERVER_ID).c_str(), "w");
+    if (fp) {
+        fprintf(fp, "0x0a01\n");
+        fclose(fp);
+    }
+    if (platdef_file() < 0)
+        fprintf(out, "warning: could not write the PlatDef table\n");
+
+    init_platdef();
+    load_i2c_mapping();
+    i2c_backend_open("sim");
+    i2c_sim_add("5 0x50 size=512");
+    init_smif();
+    reactor_init();
+    gpio_regs_init();
+    ev_setup();
+
+    bench_smif();
+    bench_i2c();
+    bench_smbios();
+    bench_ev();
+    bench_platdef();
+    bench_decode();
+    gpio_regs_close();
+    closeEV();
+
+    if (keep)
+        fprintf(out, "chif_bench: kept %s\n", root);
+    else
+        nftw(root, rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  capture.hpp
+*     Binary capture of CHIF traffic.
+*
+*     A capture file is a chif_cap_header followed by records.  Each record
+*     is a chif_cap_rec followed by rec.len bytes of packet.  Timestamps are
+*     nanoseconds since the capture was opened.  Responses are written when
+*     they are sent, so offloaded commands may appear out of order; match a
+*     response to its request by service_id and sequence.
+*
+****************************************************************************/
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define CHIF_CAP_MAGIC      "CHIFCAP1"
+#define CHIF_CAP_VERSION    1
+
+#define CHIF_CAP_REQ        0
+#define CHIF_CAP_RESP       1
+
+struct chif_cap_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+} __attribute__ ((packed));
+
+struct chif_cap_rec {
+    uint64_t ts_ns;
+    uint16_t len;
+    uint8_t dir;            // CHIF_CAP_REQ / CHIF_CAP_RESP
+    uint8_t reserved;
+} __attribute__ ((packed));
+
+/* recorder, one per process */
+extern int  capture_open(const char *path);
+extern void capture_write(int dir, const void *pkt, int len);
+extern void capture_flush(void);
+extern void capture_close(void);
+
+/* reader: capture_read() returns 1 for a record, 0 at end of file, -1 on error.
+ * pkt must hold CHIF_PKT_MAX_SIZE bytes. */
+extern FILE *capture_read_open(const char *path);
+extern int   capture_read(FILE *fp, struct chif_cap_rec *rec, void *pkt);
+
+#endif // __CAPTURE_H__
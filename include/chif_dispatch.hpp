@@ -0,0 +1,137 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  chif_dispatch.hpp
+*     Table driven dispatch of CHIF commands.
+*
+*     Every service registers its commands in a constant array of chif_cmd
+*     entries.  The index that maps a command number to its entry is built
+*     at compile time, so dispatch is one table lookup per packet and the
+*     per command metadata (request size, response size, flags) is
+*     available to the channel code for validation, tracing and caching.
+*
+****************************************************************************/
+
+#ifndef __CHIF_DISPATCH_H__
+#define __CHIF_DISPATCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <type_traits>
+
+#include "chif.hpp"
+
+#define CHIF_MSG_MAX_SIZE       (CHIF_PKT_MAX_SIZE - sizeof(struct ChifPktHeader))
+
+/* chif_cmd flags */
+#define CHIF_CMD_IDEMPOTENT     0x01    // no side effects, safe to repeat
+#define CHIF_CMD_OFFLOAD        0x02    // may block, runs on the worker pool
+#define CHIF_CMD_CACHEABLE      0x04    // response only depends on static data
+
+typedef int (*chif_cmd_handler)(void *recv, void *resp);
+
+struct chif_cmd {
+    uint16_t command;
+    uint16_t req_size;          // bytes of msg[] the handler reads
+    uint16_t resp_size;         // size of the fixed response structure
+    uint8_t  flags;
+    chif_cmd_handler handler;
+    const char *name;
+};
+
+struct chif_service {
+    uint8_t service_id;
+    const char *name;
+    uint16_t (*key)(const struct ChifPkt *pkt);  // command number to dispatch on
+    const struct chif_cmd *cmds;
+    const uint8_t *index;       // key -> cmds[] slot + 1, 0 when not registered
+    uint16_t span;              // entries in index[]
+    chif_cmd_handler fallback;  // unregistered commands
+};
+
+/* size of a packet structure, 0 for "no payload" (void or an empty struct) */
+template <typename T>
+constexpr uint16_t chif_sizeof()
+{
+    if constexpr (std::is_void_v<T> || std::is_empty_v<T>)
+        return 0;
+    else
+        return sizeof(T);
+}
+
+/* CHIF_CMD(command, request bytes read, response struct, flags, handler, name) */
+#define CHIF_CMD(cmd, req_size, resp_t, flags, handler, name) \
+    { (cmd), (uint16_t)(req_size), chif_sizeof<resp_t>(), (flags), (handler), (name) }
+
+template <size_t N>
+constexpr uint16_t chif_span(const struct chif_cmd (&cmds)[N])
+{
+    uint16_t span = 0;
+
+    for (size_t i = 0; i < N; i++) {
+        if (cmds[i].command >= span)
+            span = cmds[i].command + 1;
+    }
+    return span;
+}
+
+/* Build the key -> entry index.  Throwing makes a bad table a compile error. */
+template <uint16_t Span, size_t N>
+constexpr std::array<uint8_t, Span> chif_index(const struct chif_cmd (&cmds)[N])
+{
+    static_assert(N < 256, "too many commands for an 8-bit index");
+    std::array<uint8_t, Span> index{};
+
+    for (size_t i = 0; i < N; i++) {
+        if (index[cmds[i].command])
+            throw "duplicate CHIF command registration";
+        if (cmds[i].req_size > CHIF_MSG_MAX_SIZE)
+            throw "CHIF request size larger than a packet";
+        index[cmds[i].command] = (uint8_t)(i + 1);
+    }
+    return index;
+}
+
+/* Define the chif_service 'var' (declared below) from a chif_cmd array */
+#define CHIF_SERVICE(var, service_id, name, key, cmds, fallback) \
+    static constexpr auto var##_index = chif_index<chif_span(cmds)>(cmds); \
+    const struct chif_service var = { \
+        (service_id), (name), (key), (cmds), var##_index.data(), chif_span(cmds), (fallback) \
+    }
+
+extern const struct chif_service smif_service;
+extern const struct chif_service rom_service;
+extern const struct chif_service triton_service;
+extern const struct chif_service health_service;
+extern const struct chif_service blackbox_service;
+extern const struct chif_service embmedia_service;
+
+/* default key: the command field of the header */
+extern uint16_t chif_key_command(const struct ChifPkt *pkt);
+
+/* entry registered for a request, NULL for unknown services and commands */
+extern const struct chif_cmd *chif_lookup(const struct ChifPkt *pkt);
+
+/* dispatch one request, returns the response size or <= 0 for no response */
+extern int ChifHandler(void *recv, void *resp, int resp_len);
+
+#endif // __CHIF_DISPATCH_H__
@@ -0,0 +1,99 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  chif_reply.hpp
+*     Response builder for CHIF handlers.
+*
+*     The response buffer is not cleared before a handler runs; Reply<T>
+*     owns exactly the bytes that go on the wire.  The constructor fills
+*     the header from the request and zeroes the fixed part of the
+*     response structure T.  A variable length tail (EV data, platdef
+*     records) is written at tail() and accounted with extend(), or
+*     zero filled with pad().  send() stores the resulting pkt_size.
+*
+*         Reply<struct pkt_8130> r(recv, resp, 0x8130, SMIF_SERVICE_ID,
+*                                  offsetof(struct pkt_8130, buf));
+*         n = getEVbyName(name, (char *)r.tail(), r.room());
+*         r->sz_ev = n;
+*         r.extend(n);
+*         return r.send();
+*
+****************************************************************************/
+
+#ifndef __CHIF_REPLY_H__
+#define __CHIF_REPLY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+
+template <typename PktT = void>
+class Reply {
+public:
+    /* fixed: bytes of msg[] always sent, the whole of PktT by default */
+    Reply(const void *recv, void *resp, uint16_t command,
+          uint8_t service_id = SMIF_SERVICE_ID, uint16_t fixed = chif_sizeof<PktT>())
+        : pkt((struct ChifPkt *)resp), len(fixed < CHIF_MSG_MAX_SIZE ? fixed : CHIF_MSG_MAX_SIZE)
+    {
+        pkt->header.sequence = ((const struct ChifPkt *)recv)->header.sequence;
+        pkt->header.command = command;
+        pkt->header.service_id = service_id;
+        pkt->header.version = 0;
+        memset(pkt->msg, 0, len);
+    }
+
+    PktT *operator->() const { return (PktT *)pkt->msg; }
+    PktT *msg() const { return (PktT *)pkt->msg; }
+
+    /* first byte after what is sent so far, and how much fits behind it */
+    uint8_t *tail() const { return &pkt->msg[len]; }
+    uint16_t room() const { return CHIF_MSG_MAX_SIZE - len; }
+
+    /* the caller wrote n bytes at tail() */
+    void extend(size_t n) { len += n < room() ? n : room(); }
+
+    /* zero fill msg[] up to total bytes */
+    void pad(size_t total)
+    {
+        if (total > CHIF_MSG_MAX_SIZE)
+            total = CHIF_MSG_MAX_SIZE;
+        if (total > len) {
+            memset(&pkt->msg[len], 0, total - len);
+            len = total;
+        }
+    }
+
+    /* wire size, also stored in the header */
+    int send()
+    {
+        pkt->header.pkt_size = sizeof(struct ChifPktHeader) + len;
+        return pkt->header.pkt_size;
+    }
+
+private:
+    struct ChifPkt *pkt;
+    uint16_t len;               // bytes of msg[] sent
+};
+
+#endif // __CHIF_REPLY_H__
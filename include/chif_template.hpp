@@ -0,0 +1,59 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  chif_template.hpp
+*     Precomputed responses for CHIF_CMD_CACHEABLE commands.
+*
+*     The response of a cacheable command is fixed once init_smif() has
+*     loaded what it depends on (the board serial number of 0x0002; the
+*     rest are constants).  ChifHandler() answers those commands by copying
+*     the recorded response and patching the sequence number.  The data is
+*     only ever loaded by init_smif(), which records every template again
+*     right after; a command that answers from data that changes at run
+*     time must not be CHIF_CMD_CACHEABLE.
+*
+****************************************************************************/
+
+#ifndef __CHIF_TEMPLATE_H__
+#define __CHIF_TEMPLATE_H__
+
+#include <stdint.h>
+
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+
+/* record the response of every cacheable command of svc, replacing the old ones */
+extern void chif_template_init(const struct chif_service *svc);
+
+/* chif_template_serve()
+ *
+ * Copy the template of cmd into resp.  Returns the response size, or 0
+ * when there is no template yet and the handler has to run.
+ * Event loop only, like every cacheable command.
+ */
+extern int chif_template_serve(const struct ChifPkt *req, const struct chif_cmd *cmd,
+                               void *resp, int resp_len);
+
+/* record the response the handler of cmd just produced */
+extern void chif_template_store(const struct ChifPkt *req, const struct chif_cmd *cmd,
+                                const void *resp, int size);
+
+#endif // __CHIF_TEMPLATE_H__
@@ -27,13 +27,55 @@
 #define EV_HEAD_LEN 		(EV_NAME_MAX_LEN+2)
 #define EV_DATA_MAX_LEN	(EV_MAX_LEN - EV_HEAD_LEN)
 
-struct node {
-        struct node *forward;
-        struct node *backward;
+/*
+ * evs.dat is a log: a struct ev_log_header, then one record per set, delete
+ * or delete all, each a struct ev_rec followed by size bytes of data.  The
+ * last record of a name wins.  Records are only ever appended; when enough
+ * of the file is dead the live records are copied to a new file in the
+ * background and renamed over it.  Records are numbered from 0 after the
+ * header; on start the log is the longest run of whole records that pass
+ * their checksum and number on without a gap, and the rest is cut off.  A
+ * file that is not a log yet, or the evs.tmp and evs.new a crash can leave
+ * next to it, are sorted out before that (see ev_recover()).
+ */
+#define EV_LOG_MAGIC		"HPEEVLOG"
+#define EV_LOG_VERSION		1
+#define EV_COMPACT_MIN_DEAD	(16 * 1024)	// and at least as much dead as live
+
+/*
+ * Sets and deletes are synced in groups: the first record that is not
+ * synced yet starts a window of EV_COMMIT_MS on the event loop, and one
+ * fsync at its end covers every record written in it.  The EV names in
+ * EV_SYNC_CONF (one per line, a trailing '*' matches a prefix) and deletes
+ * of all EVs are synced before the response, and so is everything with a
+ * window of 0 (chif -evcommit 0) or without an event loop.  The records
+ * of the window are kept in memory until it is synced; when the sync
+ * fails they and the older EVs are written to a new log instead, and every
+ * record after that is synced before the response until the next boot.
+ */
+#define EV_COMMIT_MS		100
+#define EV_SYNC_CONF		"/etc/chif/ev_sync.conf"
+
+#define EV_REC_SET		1
+#define EV_REC_DEL		2
+#define EV_REC_CLEAR		3
+
+struct ev_log_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t generation;	// compactions so far
+} __attribute__ ((packed));
+
+struct ev_rec {
+        uint32_t crc;		// crc32 of the rest of the record and the data
+        uint32_t seq;		// position in the log since the last compaction
+        uint16_t size;
+        uint8_t type;
+        uint8_t rsvd;
         char name[EV_NAME_MAX_LEN];
-        long offset;
-};
+} __attribute__ ((packed));
 
+/* an EV as the old evs.dat stored it, still the unit of getSizeOfEVfile() */
 struct ev {
         uint16_t size;
         char name[EV_NAME_MAX_LEN];
@@ -42,10 +84,13 @@ struct ev {
 extern int EVError;
 
 int initEV(void);
+void closeEV(void);		// flushes first
+int flushEV(void);		// sync what the commit window holds, 0 or -1 (only in memory)
+void setEVCommitWindow(unsigned int window_ms);
 int getEVbyName(char *name, char *data, int data_len);
 struct ev *getEVbyIndex(int index, char *data, int data_len);
 int getNumOfAllEV(void);
-int getSizeOfEVfile(void);
+int getSizeOfEVfile(void);	// bytes the live EVs took in the old evs.dat
 int setEV(char *name, char *data, int data_len);
 int delEV(char *name);
 int clearEV(void);
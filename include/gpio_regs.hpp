@@ -0,0 +1,82 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  gpio_regs.hpp
+*     GPI, GPO, MEMID and CPLD registers behind SMIF 0x0088.
+*
+*     Register bytes are built from GPIO lines through the GPIO character
+*     device (v2 uAPI), as described in GPIO_REGS_CONF, one byte per line:
+*
+*       gpi   INDEX CHIP LINE0 ... LINE7     # bit 0 first, '-' for no line
+*       gpo   INDEX CHIP LINE0 ... LINE7
+*       memid INDEX CHIP LINE0 ... LINE7
+*
+*     CHIP is a /dev/gpiochipN name or path (gpio-sim chips work the same).
+*     Reads come from a snapshot.  GPI lines are watched for edges, which
+*     refresh the snapshot and latch the interrupt status (GPIST); without
+*     edge support, and for MEMID and the CPLD server ID, the snapshot is
+*     refreshed every GPIO_REGS_REFRESH_MS.  GPO lines keep the direction
+*     the board gave them and are written with one ioctl.
+*
+*     All of it runs on the event loop, like SMIF 0x0088, which answers a
+*     byte without lines with success and the value of the request.
+*
+****************************************************************************/
+
+#ifndef __GPIO_REGS_H__
+#define __GPIO_REGS_H__
+
+#include <stdint.h>
+
+#define GPIO_REGS_CONF          "/etc/chif/gpio.conf"
+#define GPIO_XREG_SERVER_ID     "/sys/class/soc/xreg/server_id"
+#define GPIO_REGS_REFRESH_MS    1000
+
+/* gpio bank of a register byte and its size, as in gpio.h (which shares
+ * its include guard with <linux/gpio.h>, so cannot be used here) */
+#define GPIO_REGS_GPI           1
+#define GPIO_REGS_GPO           2
+#define GPIO_REGS_MEMID         4
+#define GPIO_REGS_GPI_BYTES     8
+#define GPIO_REGS_GPO_BYTES     16
+#define GPIO_REGS_MEMID_BYTES   256
+
+/* gpio_regs_init()
+ *
+ * Open the lines of GPIO_REGS_CONF and the server ID register and start
+ * watching them.  After reactor_init(); a missing configuration leaves
+ * every GPIO byte unmapped.
+ */
+extern int gpio_regs_init(void);
+extern void gpio_regs_close(void);
+
+/* 0, -ENOENT for a byte with no lines, -EIO when the lines cannot be read or written */
+extern int gpio_byte_get(int bank, uint32_t index, uint8_t *val);
+extern int gpio_byte_put(int bank, uint32_t index, uint8_t val);
+
+/* GPI interrupt enable and latched status; writing the status clears the bits set in val */
+extern int gpio_gpi_int_get(bool status, uint32_t index, uint8_t *val);
+extern int gpio_gpi_int_put(bool status, uint32_t index, uint8_t val);
+
+/* CPLD server ID byte 1 (low) or 2, 0, -ENOENT for another index or -EIO */
+extern int gpio_xreg_get(uint8_t index, uint8_t *regValue);
+
+#endif // __GPIO_REGS_H__
@@ -0,0 +1,77 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  i2c_cache.hpp
+*     Read cache for I2C EEPROMs behind SMIF 0x0072.
+*
+*     Off unless enabled with a TTL (chif -i2ccache MS).  Only devices on
+*     the policy list are cached; the list is derived from the SMBIOS DIMM
+*     records (type 227 segment and address, type 17 memory type) after
+*     every SMBIOS download.  An entry is keyed by (kernel bus, address,
+*     write prefix, read length) and dropped when it expires, on any write
+*     to the device, and on a DDR4 SPD page select on its bus.
+*
+****************************************************************************/
+
+#ifndef __I2C_CACHE_H__
+#define __I2C_CACHE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define I2C_CACHE_ENTRIES   4096
+#define I2C_CACHE_PREFIX    4       // longest write prefix (the offset) cached
+
+/* policy of a device */
+enum {
+    I2C_CACHE_NONE = 0,
+    I2C_CACHE_EEPROM,       // plain EEPROM, DDR3/DDR4 SPD
+    I2C_CACHE_SPD5,         // DDR5 SPD hub: only NVM reads (offset bit 7 set), not registers
+};
+
+/* ttl_ms of 0 disables the cache */
+extern void i2c_cache_enable(unsigned int ttl_ms);
+
+/* cache reads of the 7-bit address addr on segment with policy kind */
+extern void i2c_cache_allow(uint8_t segment, uint8_t addr, int kind);
+
+/* replace the policy list with the SPD EEPROMs of the SMBIOS DIMM records */
+extern void i2c_cache_policy_smbios(void);
+
+/* copy a cached read into rbuf, true on a hit */
+extern bool i2c_cache_get(uint8_t segment, int bus, uint8_t addr, const uint8_t *wbuf,
+                          uint8_t wlen, uint8_t *rbuf, uint8_t rlen);
+
+/* i2c_cache_update()
+ *
+ * Account a transaction that went to the bus: a successful cacheable read
+ * is stored, anything else that may have changed the device invalidates
+ * what is cached for it (whatever rc says).
+ */
+extern void i2c_cache_update(uint8_t segment, int bus, uint8_t addr, const uint8_t *wbuf,
+                             uint8_t wlen, const uint8_t *rbuf, uint8_t rlen, int rc);
+
+extern void i2c_cache_clear(void);
+
+/* one line of hit/miss counters when the cache is enabled, reset clears them */
+extern void i2c_cache_stats(FILE *fp, bool reset);
+
+#endif // __I2C_CACHE_H__
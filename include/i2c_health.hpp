@@ -0,0 +1,62 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  i2c_health.hpp
+*     Per-device circuit breaker for SMIF 0x0072.
+*
+*     Devices are tracked by (kernel bus, 7-bit address) once they fail.
+*     I2C_HEALTH_TRIP consecutive failed transactions open the circuit:
+*     requests are answered at once with the last error until the backoff
+*     runs out, then one request goes to the bus as a probe.  A good probe
+*     closes the circuit, a bad one doubles the backoff (up to
+*     I2C_HEALTH_BACKOFF_MAX_MS).  Absent DIMMs and PSUs then cost one
+*     transaction per backoff instead of a retry on every request.
+*
+*     The table is printed with the USR1 statistics.
+*
+****************************************************************************/
+
+#ifndef __I2C_HEALTH_H__
+#define __I2C_HEALTH_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define I2C_HEALTH_TRIP             3       // consecutive failures that open the circuit
+#define I2C_HEALTH_BACKOFF_MS       1000    // first open period
+#define I2C_HEALTH_BACKOFF_MAX_MS   60000
+#define I2C_HEALTH_ENTRIES          1024    // devices tracked, failures beyond are not
+
+/* i2c_health_check()
+ *
+ * I2C_SUCCESS when a transaction to the device may go to the bus, else the
+ * code to answer with.  *retry is false when a failure should not be
+ * retried: the device failed last time or this is the half-open probe.
+ */
+extern int i2c_health_check(int bus, uint8_t addr, bool *retry);
+
+/* account the result of a transaction that went to the bus */
+extern void i2c_health_record(uint8_t segment, int bus, uint8_t addr, int rc);
+
+extern void i2c_health_dump(FILE *fp);
+extern void i2c_health_reset(void);
+
+#endif // __I2C_HEALTH_H__
@@ -17,8 +17,15 @@
 // limitations under the License.
 */
 
+#ifndef __I2C_MAPPING_H__
+#define __I2C_MAPPING_H__
+
+#include <stdint.h>
+#include <memory>
+
 #define I2C_MAPPING "/tmp/ubm/ubm_map.txt"
 #define MAX_I2C_TABLE_REMAP 256
+#define I2C_SEGMENTS        256     // APML segment IDs are one byte
 
 
 struct i2cMapEntry {
@@ -27,7 +34,25 @@ struct i2cMapEntry {
 	unsigned short int i2cKernelSegment;
 };
 
-extern struct i2cMapEntry i2cSystemEntries[MAX_I2C_TABLE_REMAP];
-extern int i2cAllocatedEntries;
+/* One version of the mapping file and the segment -> kernel bus table built
+ * from it and the APML topology.  A published map is never modified; a
+ * reload or a topology change publishes a new one. */
+struct i2c_map {
+	int entries;
+	struct i2cMapEntry entry[MAX_I2C_TABLE_REMAP];
+	int16_t segment_bus[I2C_SEGMENTS];     // -1 when the segment has no mapping
+};
+
+/* current map; the snapshot stays valid for as long as the caller holds it */
+extern std::shared_ptr<const struct i2c_map> i2c_map_get(void);
 
+/* (re)read I2C_MAPPING and publish a new map */
 void load_i2c_mapping();
+
+/* rebuild the segment table for a new APML topology and publish it */
+extern void build_i2c_segment_map(void);
+
+/* reload I2C_MAPPING whenever it is written or replaced (event loop) */
+extern int i2c_mapping_watch(void);
+
+#endif // __I2C_MAPPING_H__
@@ -0,0 +1,61 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  i2c_sim.hpp
+*     Simulated I2C buses, the "sim" backend of i2c_xfer.hpp.
+*
+*     Lets the 0x0072 path (segment mapping, retries, backoff, cache) run
+*     and be timed on a host without I2C hardware.  Every device is an
+*     EEPROM with an address pointer: a write sets the pointer (one byte,
+*     two with addr16) and stores the rest, a read returns bytes from the
+*     pointer on.  One line per device:
+*
+*       BUS ADDR [size=N] [addr16] [fill=B] [file=PATH] [latency=US]
+*                [byte=US] [nak=PCT] [timeout=PCT] [timeout_us=US]
+*
+*     ADDR is the 7-bit address.  Contents are PATH, else fill, else the
+*     offset xor the address.  A transaction takes latency plus byte per
+*     byte on the wire and holds the bus meanwhile, so transactions on one
+*     bus are serialized and those on different buses are not.  nak and
+*     timeout fail that share of transactions (a timeout takes timeout_us,
+*     default 25 ms, the SMBus limit) from a per-device seed, the same way
+*     on every run.  A missing device NACKs, a missing bus does not exist.
+*     '#' starts a comment.
+*
+****************************************************************************/
+
+#ifndef __I2C_SIM_H__
+#define __I2C_SIM_H__
+
+#include "i2c_xfer.hpp"
+
+extern const struct i2c_backend i2c_sim_backend;
+
+/* add the devices described in path, 0 or -1 */
+extern int i2c_sim_load(const char *path);
+
+/* add (or replace) one device from a line in the format above, 0 or -1 */
+extern int i2c_sim_add(const char *line);
+
+/* remove every simulated bus and device */
+extern void i2c_sim_clear(void);
+
+#endif // __I2C_SIM_H__
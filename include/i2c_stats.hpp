@@ -0,0 +1,49 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  i2c_stats.hpp
+*     Latency and error statistics of the SMIF 0x0072 transactions.
+*
+*     Every request that goes to the bus is accounted to its (segment,
+*     address): count, errors, NACKs, retries and a lat_hist of the whole
+*     request including retries.  The dump adds them up per kernel bus and
+*     per APML segment as well, so a slow mux branch shows up next to the
+*     device on it.  With -trace each request is also one trace record.
+*
+*     The tables are printed with the USR1 statistics.
+*
+****************************************************************************/
+
+#ifndef __I2C_STATS_H__
+#define __I2C_STATS_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define I2C_STATS_SLOTS     256     // power of 2, devices tracked; the rest are "other"
+
+extern void i2c_stats_record(uint8_t segment, int bus, uint8_t addr, uint8_t wlen, uint8_t rlen,
+                             int retries, int rc, uint64_t ns);
+
+extern void i2c_stats_dump(FILE *fp);
+extern void i2c_stats_reset(void);
+
+#endif // __I2C_STATS_H__
@@ -0,0 +1,74 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  i2c_xfer.hpp
+*     In-process I2C transactions.
+*
+*     A transaction is an optional write followed by an optional read with
+*     a repeated start, the same thing "i2ctransfer -y -f BUS wN@ADDR ... rM"
+*     does.  Results are I2C_SUCCESS or one of the other codes in
+*     i2c_return_codes.hpp.  The backend carries it out:
+*
+*     dev             one I2C_RDWR ioctl on /dev/i2c-<bus> (default); the
+*                     bus device is opened on first use and kept open
+*     sim, sim:PATH   the simulated buses of i2c_sim.hpp, with the devices
+*                     described in PATH
+*
+****************************************************************************/
+
+#ifndef __I2C_XFER_H__
+#define __I2C_XFER_H__
+
+#include <stdint.h>
+
+#include "i2c_return_codes.hpp"
+
+#define I2C_XFER_MAX_LEN    32      // bytes written or read by one transaction
+#define I2C_XFER_MAX_BUS    1024    // kernel bus numbers with a cached descriptor
+
+#define I2C_DEFAULT_BACKEND "dev"
+
+struct i2c_backend {
+    const char *name;
+    /* arguments already checked against the limits above */
+    int (*xfer)(int bus, uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+                uint8_t *rbuf, uint8_t rlen);
+    void (*close)(void);
+};
+
+/* select the backend described by spec before the first transaction, 0 or -1 */
+extern int i2c_backend_open(const char *spec);
+
+/* i2c_xfer()
+ *
+ * Write wlen bytes to the 7-bit address addr on bus, then read rlen bytes
+ * into rbuf.  With both lengths 0 only the address is sent.
+ */
+extern int i2c_xfer(int bus, uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+                    uint8_t *rbuf, uint8_t rlen);
+
+/* I2C_* code for an errno of the I2C_RDWR ioctl or the open of the bus */
+extern int i2c_xfer_errno(int err);
+
+/* close the backend: the cached bus descriptors, the simulated devices */
+extern void i2c_xfer_close(void);
+
+#endif // __I2C_XFER_H__
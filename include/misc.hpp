@@ -24,10 +24,37 @@ struct pkt_gen {
     uint32_t ErrorCode;
 } __attribute__ ((packed));
 
-extern int EmbMediaHandler(void *recv, void *resp);
-extern int HealthHandler(void *recv, void *resp);
-extern int BlackBoxHandler(void *recv, void *resp);
-extern void dbPrintf(const char *format, ...);
+/* compile time log levels, the build sets CHIF_LOG_LEVEL (meson -Dlog_level=) */
+#define CHIF_LOG_ERROR  1       // printf() only
+#define CHIF_LOG_DEBUG  2       // dbPrintf(), hexdump() with -dbp
+#define CHIF_LOG_TRACE  3       // CHIF_TRACE() with -trace, see trace.hpp
+
+#ifndef CHIF_LOG_LEVEL
+#define CHIF_LOG_LEVEL  CHIF_LOG_TRACE
+#endif
+
+/* -dbp */
+extern bool gdbPrint;
+
+extern void chif_dbprintf(const char *format, ...);
+
+/* debug output; the arguments are not even evaluated unless -dbp is set */
+#if CHIF_LOG_LEVEL >= CHIF_LOG_DEBUG
+#define dbPrintf(...) \
+    do { if (__builtin_expect(gdbPrint, 0)) chif_dbprintf(__VA_ARGS__); } while (0)
+#else
+#define dbPrintf(...) \
+    do { if (0) chif_dbprintf(__VA_ARGS__); } while (0)
+#endif
+
+/* skip systemd and D-Bus side effects (benchmarks, tools) */
+extern bool gChifOffline;
+
+/* persistent state paths, relocated under $CHIF_ROOT when it is set */
+extern const char *chif_path(const char *path);
+
+/* chif_path() of a constant path, resolved once per use site */
+#define CHIF_PATH(p)    ([]() { static const char *s = chif_path(p); return s; }())
 
 #endif // __EMBMEDIA_H__
 
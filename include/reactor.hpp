@@ -0,0 +1,62 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  reactor.hpp
+*     epoll based event loop.  The CHIF channel, timers (timerfd), signals
+*     (signalfd) and background work completions are all multiplexed here
+*     so that the daemon has a single thread of control for packet I/O.
+*
+****************************************************************************/
+
+#ifndef __REACTOR_H__
+#define __REACTOR_H__
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#define REACTOR_MAX_HANDLERS  64
+
+typedef void (*reactor_fd_cb)(int fd, uint32_t events, void *ctx);
+typedef void (*reactor_timer_cb)(int timer, void *ctx);
+typedef void (*reactor_signal_cb)(int signo, int value, void *ctx);
+
+/* reactor_init() must be called before any other reactor routine */
+extern int  reactor_init(void);
+
+/* watch a file descriptor, events are EPOLLIN/EPOLLOUT/... */
+extern int  reactor_add_fd(int fd, uint32_t events, reactor_fd_cb cb, void *ctx);
+extern int  reactor_mod_fd(int fd, uint32_t events);
+extern int  reactor_del_fd(int fd);
+
+/* timers - returns a timer handle (>=0) or -1.  interval_ms of 0 is one-shot,
+ * first_ms of 0 leaves the timer disarmed until reactor_arm_timer() */
+extern int  reactor_add_timer(unsigned int first_ms, unsigned int interval_ms,
+                              reactor_timer_cb cb, void *ctx);
+extern int  reactor_arm_timer(int timer, unsigned int first_ms, unsigned int interval_ms);
+
+/* signals are blocked for normal delivery and routed through a signalfd */
+extern int  reactor_add_signal(int signo, reactor_signal_cb cb, void *ctx);
+
+/* run until reactor_stop() is called or an unrecoverable error occurs */
+extern int  reactor_run(void);
+extern void reactor_stop(void);
+
+#endif // __REACTOR_H__
@@ -21,7 +21,9 @@
 #define __SMIF_H__
 
 extern void init_smif(void);
-extern int SmifHandler(void *recv, void *resp);
 extern int hexdump(void *p, int len);
+
+/* kernel I2C bus of a 0x0072 or 0x007a request, -1 for other requests and unmapped segments */
+extern int smif_i2c_bus(const void *recv);
     
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  stats.hpp
+*     Always-on request statistics.
+*
+*     lat_hist is a log2 bucketed latency histogram (bucket n counts
+*     samples of [2^(n-1), 2^n) microseconds) cheap enough to update on
+*     every request.  The CHIF channel keeps one pair of histograms
+*     (handler time and write time) plus request and error counts for each
+*     (service_id, command).
+*
+*     kill -USR1 <pid>           dump the statistics to stdout
+*     kill -s USR1 -q 1 <pid>    dump, then reset them
+*
+****************************************************************************/
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "chif.hpp"
+
+#define LAT_HIST_BUCKETS    32
+
+struct lat_hist {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t bucket[LAT_HIST_BUCKETS];
+};
+
+/* monotonic clock in nanoseconds */
+extern uint64_t stats_now_ns(void);
+
+extern void lat_hist_add(struct lat_hist *h, uint64_t ns);
+/* add the samples of src to h */
+extern void lat_hist_merge(struct lat_hist *h, const struct lat_hist *src);
+/* upper bound in microseconds of the bucket holding percentile pct (0-100) */
+extern uint64_t lat_hist_percentile(const struct lat_hist *h, double pct);
+/* one line summary followed by the non-empty buckets */
+extern void lat_hist_print(FILE *fp, const char *label, const struct lat_hist *h);
+
+/* chif_stats_record()
+ *
+ * Account one request.  out_size is the handler result (<= 0 means no
+ * response was produced), write_rc the result of sending the response.
+ * Must be called from the event loop.
+ */
+extern void chif_stats_record(const struct ChifPkt *req, int out_size, uint64_t handler_ns,
+                              int write_rc, uint64_t write_ns);
+
+extern void chif_stats_dump(FILE *fp);
+extern void chif_stats_reset(void);
+
+/* SIGUSR1 handler for reactor_add_signal(); value 1 also resets */
+extern void chif_stats_signal(int signo, int value, void *ctx);
+
+#endif // __STATS_H__
@@ -54,7 +54,6 @@ struct EntryPointStructure30 {
     uint64_t structTableAddr;
 }__attribute__((packed));
 
-int RomHandler(void *recv, void *resp, int resp_len);
 int WriteSmbiosRecords(char *path, char *buffer, int size);
 bool syncSmbiosData();
 
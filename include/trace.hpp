@@ -0,0 +1,84 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  trace.hpp
+*     In-memory trace ring.
+*
+*     CHIF_TRACE() stores a timestamp, the format string and up to
+*     CHIF_TRACE_ARGS integer arguments in a fixed ring of binary records.
+*     Nothing is formatted until the ring is dumped, so tracing can stay
+*     enabled on the packet path.  Any thread may trace; the oldest
+*     records are overwritten.
+*
+*     chif -trace                enable tracing at startup
+*     kill -USR2 <pid>           dump the ring to stdout
+*     kill -s USR2 -q 1 <pid>    dump, then clear it
+*
+*     The format must be a string literal.  Arguments are integers (or
+*     enums); print pointers with %p after casting them to uintptr_t.
+*     %s is not supported because the string may be gone by the dump.
+*
+****************************************************************************/
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "misc.hpp"
+
+#define CHIF_TRACE_RING     4096    // records, power of 2
+#define CHIF_TRACE_ARGS     8
+
+/* tracing on/off at run time, compiled in when CHIF_LOG_LEVEL >= CHIF_LOG_TRACE */
+extern bool gChifTrace;
+
+extern void chif_trace_put(const char *fmt, int nargs, const uint64_t *args);
+
+template <typename... Args>
+inline void chif_trace(const char *fmt, Args... args)
+{
+    static_assert(sizeof...(Args) <= CHIF_TRACE_ARGS, "too many CHIF_TRACE arguments");
+    static_assert(((std::is_integral_v<Args> || std::is_enum_v<Args>) && ...),
+                  "CHIF_TRACE arguments must be integers, they are formatted at dump time");
+    const uint64_t a[sizeof...(Args) + 1] = { (uint64_t)args... };
+
+    chif_trace_put(fmt, sizeof...(Args), a);
+}
+
+#if CHIF_LOG_LEVEL >= CHIF_LOG_TRACE
+#define CHIF_TRACE(fmt, ...) \
+    do { if (__builtin_expect(gChifTrace, 0)) chif_trace("" fmt, ##__VA_ARGS__); } while (0)
+#else
+#define CHIF_TRACE(fmt, ...) \
+    do { if (0) chif_trace("" fmt, ##__VA_ARGS__); } while (0)
+#endif
+
+/* format the records still in the ring, oldest first */
+extern void chif_trace_dump(FILE *fp);
+extern void chif_trace_clear(void);
+
+/* SIGUSR2 handler for reactor_add_signal(); value 1 also clears */
+extern void chif_trace_signal(int signo, int value, void *ctx);
+
+#endif // __TRACE_H__
@@ -0,0 +1,75 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  transport.hpp
+*     Where CHIF packets come from and go to.  Every transport ends up as a
+*     pair of descriptors that carry exactly one packet per read()/write(),
+*     so the channel code does not care which one is in use:
+*
+*     /dev/chif24, dev:PATH   the GXP CHIF character device (default)
+*     unix:PATH               SOCK_SEQPACKET socket listening at PATH, one
+*                             client at a time (load generators, tests)
+*     fd:N                    an inherited socketpair / SEQPACKET socket
+*     file:PATH               requests from a capture file (see capture.hpp),
+*                             responses are discarded
+*
+*     Sources that cannot be polled (a char device without poll support, a
+*     capture file) are fed through a socketpair by a reader thread.
+*
+****************************************************************************/
+
+#ifndef __TRANSPORT_H__
+#define __TRANSPORT_H__
+
+#include <stdbool.h>
+
+#define CHIF_DEFAULT_TRANSPORT  "/dev/chif24"
+
+enum {
+    CHIF_TRANSPORT_DEV = 0,
+    CHIF_TRANSPORT_UNIX,
+    CHIF_TRANSPORT_FD,
+    CHIF_TRANSPORT_FILE
+};
+
+struct chif_transport {
+    int type;
+    int rx_fd;          // pollable, one request per read(); -1 until a client connects
+    int tx_fd;          // one response per write()
+    int dev_fd;         // device, capture file or listening socket
+    bool reconnect;     // the peer going away is not fatal, wait for the next one
+};
+
+/* open the transport described by spec, returns 0 or -1 */
+extern int  chif_transport_open(struct chif_transport *t, const char *spec);
+
+/* accept the next client of a listening transport, returns 0 or -1 */
+extern int  chif_transport_accept(struct chif_transport *t);
+
+/* forget the current client of a listening transport */
+extern void chif_transport_disconnect(struct chif_transport *t);
+
+extern void chif_transport_close(struct chif_transport *t);
+
+/* client end of unix:PATH or fd:N (load generators), returns the socket or -1 */
+extern int  chif_transport_connect(const char *spec);
+
+#endif // __TRANSPORT_H__
@@ -20,6 +20,6 @@
 #ifndef __TRITON_H__
 #define __TRITON_H__
 
-extern int TritonHandler(void *recv, void *resp);
+extern int Triton_Response(void *recv, void *resp);
 
 #endif
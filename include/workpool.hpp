@@ -0,0 +1,75 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  workpool.hpp
+*     Bounded worker pool for CHIF commands that are too slow to run on the
+*     event loop (I2C transactions, service restarts, D-Bus calls).
+*
+*     Each job carries its own request and response buffer, so a response is
+*     always built from (and matched by the sequence number of) its own
+*     request.  Jobs with the same lane key never run concurrently and keep
+*     their submission order.  Completions are handed back to the event loop
+*     through an eventfd and written to the channel from there.
+*
+****************************************************************************/
+
+#ifndef __WORKPOOL_H__
+#define __WORKPOOL_H__
+
+#include <stdint.h>
+#include "chif.hpp"
+
+#define WORKPOOL_WORKERS   4
+#define WORKPOOL_JOBS      32
+
+struct chif_job {
+    struct chif_job *next;
+    uint32_t lane;
+    int i2c_bus;                // kernel bus resolved at submit, -1 when none
+    int in_size;
+    int out_size;
+    uint64_t handler_ns;        // time spent in the handler
+    uint8_t recv[CHIF_PKT_MAX_SIZE];
+    uint8_t resp[CHIF_PKT_MAX_SIZE];
+};
+
+typedef int  (*workpool_handler)(void *recv, void *resp, int resp_len);
+typedef void (*workpool_done)(struct chif_job *job);
+
+/* start the workers and register the completion eventfd with the reactor */
+extern int  workpool_init(int workers, workpool_handler handler, workpool_done done);
+
+/* copy a request into a job and queue it behind earlier jobs of its lane.
+ * Blocks (processing completions) while every job buffer is in use. */
+extern int  workpool_submit(const void *recv, int in_size, uint32_t lane, int i2c_bus);
+
+/* the job the calling worker is running, NULL outside of a handler on a worker */
+extern const struct chif_job *workpool_current(void);
+
+/* number of jobs submitted for a service that have not completed yet */
+extern int  workpool_pending(uint8_t service_id);
+
+/* process completions until every submitted job has finished */
+extern void workpool_drain(void);
+
+extern void workpool_shutdown(void);
+
+#endif // __WORKPOOL_H__
@@ -0,0 +1,122 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <mutex>
+
+#include "chif.hpp"
+#include "capture.hpp"
+#include "stats.hpp"
+
+static FILE *cap_fp;
+static uint64_t cap_start_ns;
+static std::mutex cap_lock;
+
+int capture_open(const char *path)
+{
+    struct chif_cap_header hdr;
+
+    cap_fp = fopen(path, "wb");
+    if (!cap_fp) {
+        printf("capture: cannot create %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CHIF_CAP_MAGIC, sizeof(hdr.magic));
+    hdr.version = CHIF_CAP_VERSION;
+    fwrite(&hdr, sizeof(hdr), 1, cap_fp);
+
+    cap_start_ns = stats_now_ns();
+    printf("capture: recording CHIF traffic to %s\n", path);
+    return 0;
+}
+
+void capture_write(int dir, const void *pkt, int len)
+{
+    struct chif_cap_rec rec;
+
+    if (!cap_fp || len <= 0)
+        return;
+    if (len > CHIF_PKT_MAX_SIZE)
+        len = CHIF_PKT_MAX_SIZE;
+
+    rec.ts_ns = stats_now_ns() - cap_start_ns;
+    rec.len = len;
+    rec.dir = dir;
+    rec.reserved = 0;
+
+    std::lock_guard<std::mutex> lk(cap_lock);
+    fwrite(&rec, sizeof(rec), 1, cap_fp);
+    fwrite(pkt, len, 1, cap_fp);
+}
+
+void capture_flush(void)
+{
+    std::lock_guard<std::mutex> lk(cap_lock);
+
+    if (cap_fp)
+        fflush(cap_fp);
+}
+
+void capture_close(void)
+{
+    std::lock_guard<std::mutex> lk(cap_lock);
+
+    if (cap_fp) {
+        fclose(cap_fp);
+        cap_fp = NULL;
+    }
+}
+
+FILE *capture_read_open(const char *path)
+{
+    struct chif_cap_header hdr;
+    FILE *fp;
+
+    fp = fopen(path, "rb");
+    if (!fp) {
+        printf("capture: cannot open %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+        memcmp(hdr.magic, CHIF_CAP_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != CHIF_CAP_VERSION) {
+        printf("capture: %s is not a CHIF capture\n", path);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+int capture_read(FILE *fp, struct chif_cap_rec *rec, void *pkt)
+{
+    if (fread(rec, sizeof(*rec), 1, fp) != 1)
+        return feof(fp) ? 0 : -1;
+
+    if (rec->len > CHIF_PKT_MAX_SIZE || fread(pkt, rec->len, 1, fp) != 1) {
+        printf("capture: truncated record\n");
+        return -1;
+    }
+    return 1;
+}
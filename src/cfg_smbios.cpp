@@ -95,7 +95,7 @@ int smbios_cfg_read( smbios_cfg_type *smbios_cfg_ptr )
     size_t bytesToRead = sizeof(smbios_cfg_type);
     size_t bytesRead;
 
-    fd = fopen(SMBIOS_DATA_FILE,"rb");
+    fd = fopen(CHIF_PATH(SMBIOS_DATA_FILE),"rb");
     if (fd !=NULL) {
         bytesRead = fread(smbios_cfg_ptr, 1, bytesToRead, fd);
         if (bytesRead == sizeof(smbios_cfg_type)) {
@@ -142,7 +142,7 @@ int smbios_cfg_write( const smbios_cfg_type * smbios_cfg_ptr )
     smbios_cfg_writecount++;
     smbios_db = *smbios_cfg_ptr; //sync with global variable
 
-    fd = fopen(SMBIOS_DATA_FILE,"wb+");
+    fd = fopen(CHIF_PATH(SMBIOS_DATA_FILE),"wb+");
     if (fd !=NULL) {
         bytesToXfer = sizeof(smbios_cfg_type);
         dbPrintf("SCW, Writing %ld bytes\n", bytesToXfer);
@@ -151,14 +151,14 @@ int smbios_cfg_write( const smbios_cfg_type * smbios_cfg_ptr )
 
         if (bytesXfered != bytesToXfer) {
             dbPrintf("Failed: %ld != %ld\n", bytesXfered, bytesXfered);
-            dbPrintf("Error writing to %s and bytes written %ld\n", SMBIOS_DATA_FILE, bytesXfered);
+            dbPrintf("Error writing to %s and bytes written %ld\n", CHIF_PATH(SMBIOS_DATA_FILE), bytesXfered);
             retval = -1;
         }
     
         fclose(fd);
     
     } else {
-       printf("SMBIOS Error: opening %s, fd=%ld\n", SMBIOS_DATA_FILE, (uint64_t)fd);
+       printf("SMBIOS Error: opening %s, fd=%ld\n", CHIF_PATH(SMBIOS_DATA_FILE), (uint64_t)fd);
        retval = -1;
     }
 
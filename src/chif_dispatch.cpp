@@ -0,0 +1,156 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "chif_reply.hpp"
+#include "chif_template.hpp"
+#include "misc.hpp"
+
+struct chif_service_reg {
+    uint8_t service_id;
+    const struct chif_service *service;
+};
+
+/* services are addressed directly by the service_id of the header */
+static constexpr struct chif_service_reg service_regs[] = {
+    { SMIF_SERVICE_ID,          &smif_service },
+    { ROM_SERVICE_ID,           &rom_service },
+    { TRITON_SERVICE_ID,        &triton_service },
+    { CHIF_SERVICE_ID_HEALTH,   &health_service },
+    { CHIF_SERVICE_ID_BLACKBOX, &blackbox_service },    // or AHS
+    { CHIF_SERVICE_ID_EMBMEDIA, &embmedia_service },
+};
+
+static constexpr std::array<const struct chif_service *, 256> chif_build_services()
+{
+    std::array<const struct chif_service *, 256> services{};
+
+    for (const struct chif_service_reg &reg : service_regs) {
+        if (services[reg.service_id])
+            throw "duplicate CHIF service registration";
+        services[reg.service_id] = reg.service;
+    }
+    return services;
+}
+
+static constexpr auto chif_services = chif_build_services();
+
+uint16_t chif_key_command(const struct ChifPkt *pkt)
+{
+    return pkt->header.command;
+}
+
+static const struct chif_cmd *chif_service_cmd(const struct chif_service *svc,
+                                               const struct ChifPkt *pkt)
+{
+    uint16_t key = svc->key(pkt);
+
+    if (key >= svc->span || !svc->index[key])
+        return NULL;
+    return &svc->cmds[svc->index[key] - 1];
+}
+
+const struct chif_cmd *chif_lookup(const struct ChifPkt *pkt)
+{
+    const struct chif_service *svc = chif_services[pkt->header.service_id];
+
+    if (!svc)
+        return NULL;
+    return chif_service_cmd(svc, pkt);
+}
+
+int Unknown_Response(void *recv, void *resp)
+{
+    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
+    Reply<> reply(recv, resp, recvPkt->header.command | 0x8000);
+
+    // 4 bytes longer than the request, at least the error code
+    if (recvPkt->header.pkt_size > sizeof(struct ChifPktHeader))
+        reply.pad(recvPkt->header.pkt_size + 4 - sizeof(struct ChifPktHeader));
+    reply.pad(sizeof(uint32_t));
+
+    *(uint32_t *)reply.msg() = 0xFFFF0000;
+    return reply.send();
+}
+
+int UnknownHandler(void *recv, void *resp, int resp_len)
+{
+    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
+
+    (void)resp_len;
+    printf("UnknownHandler: command:0x%08x\n", recvPkt->header.command);
+    return Unknown_Response(recv, resp);
+}
+
+/* chif_check_request()
+ *
+ * A request shorter than the structure its handler reads would leave the
+ * handler looking at whatever an earlier packet left in the buffer.  Zero
+ * the missing bytes so short requests behave the same every time.
+ */
+static void chif_check_request(struct ChifPkt *pkt, const struct chif_cmd *cmd)
+{
+    int len = (int)pkt->header.pkt_size - (int)sizeof(struct ChifPktHeader);
+
+    if (len < 0)
+        len = 0;
+    if (len >= cmd->req_size)
+        return;
+
+    dbPrintf("%s: short request, %d of %d bytes\n", cmd->name, len, cmd->req_size);
+    memset(&pkt->msg[len], 0, cmd->req_size - len);
+}
+
+int ChifHandler(void *recv, void *resp, int resp_len)
+{
+    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
+    const struct chif_service *svc = chif_services[recvPkt->header.service_id];
+    const struct chif_cmd *cmd;
+    int size;
+
+    if (!svc)
+        return UnknownHandler(recv, resp, resp_len);
+
+    cmd = chif_service_cmd(svc, recvPkt);
+    if (!cmd) {
+        dbPrintf("%s: command:0x%04x not registered\n", svc->name, svc->key(recvPkt));
+        return svc->fallback(recv, resp);
+    }
+
+    dbPrintf("%s_0x%04x: %s\n", svc->name, cmd->command, cmd->name);
+    if (cmd->flags & CHIF_CMD_CACHEABLE) {
+        size = chif_template_serve(recvPkt, cmd, resp, resp_len);
+        if (size > 0)
+            return size;
+    }
+
+    // handlers build their response with Reply<>, nothing to clear here
+    chif_check_request(recvPkt, cmd);
+    size = cmd->handler(recv, resp);
+
+    // no template yet, recorded for the next request
+    if ((cmd->flags & CHIF_CMD_CACHEABLE) && size > 0)
+        chif_template_store(recvPkt, cmd, resp, size);
+    return size;
+}
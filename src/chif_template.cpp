@@ -0,0 +1,126 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "chif_template.hpp"
+#include "misc.hpp"
+
+#define CHIF_TEMPLATE_SLOTS 64      // power of 2, well above the cacheable commands
+
+struct chif_template {
+    bool used;
+    uint8_t service_id;
+    uint16_t command;
+    int size;
+    uint8_t *pkt;
+};
+
+static struct chif_template templates[CHIF_TEMPLATE_SLOTS];
+
+static struct chif_template *chif_template_slot(uint8_t service_id, uint16_t command, bool create)
+{
+    uint32_t key = ((uint32_t)service_id << 16) | command;
+    uint32_t i, slot;
+
+    for (i = 0; i < CHIF_TEMPLATE_SLOTS; i++) {
+        slot = (key * 2654435761u + i) & (CHIF_TEMPLATE_SLOTS - 1);
+        if (!templates[slot].used) {
+            if (!create)
+                return NULL;
+            templates[slot].used = true;
+            templates[slot].service_id = service_id;
+            templates[slot].command = command;
+            return &templates[slot];
+        }
+        if (templates[slot].service_id == service_id && templates[slot].command == command)
+            return &templates[slot];
+    }
+    return NULL;
+}
+
+int chif_template_serve(const struct ChifPkt *req, const struct chif_cmd *cmd,
+                        void *resp, int resp_len)
+{
+    struct chif_template *t;
+
+    t = chif_template_slot(req->header.service_id, cmd->command, false);
+    if (!t || !t->pkt || t->size > resp_len)
+        return 0;
+
+    memcpy(resp, t->pkt, t->size);
+    ((struct ChifPkt *)resp)->header.sequence = req->header.sequence;
+    return t->size;
+}
+
+void chif_template_store(const struct ChifPkt *req, const struct chif_cmd *cmd,
+                         const void *resp, int size)
+{
+    struct chif_template *t;
+    uint8_t *pkt;
+
+    if (size < (int)sizeof(struct ChifPktHeader) || size > CHIF_PKT_MAX_SIZE)
+        return;
+
+    t = chif_template_slot(req->header.service_id, cmd->command, true);
+    if (!t)
+        return;
+
+    if (t->size != size) {
+        pkt = (uint8_t *)realloc(t->pkt, size);
+        if (!pkt)
+            return;
+        t->pkt = pkt;
+        t->size = size;
+    }
+    memcpy(t->pkt, resp, size);
+}
+
+void chif_template_init(const struct chif_service *svc)
+{
+    static uint8_t recv[CHIF_PKT_MAX_SIZE], resp[CHIF_PKT_MAX_SIZE];
+    struct ChifPkt *req = (struct ChifPkt *)recv;
+    const struct chif_cmd *cmd;
+    uint16_t k;
+    int size;
+
+    for (k = 0; k < svc->span; k++) {
+        if (!svc->index[k])
+            continue;
+        cmd = &svc->cmds[svc->index[k] - 1];
+        if (!(cmd->flags & CHIF_CMD_CACHEABLE))
+            continue;
+
+        memset(recv, 0, sizeof(recv));
+        req->header.pkt_size = sizeof(struct ChifPktHeader) + cmd->req_size;
+        req->header.command = cmd->command;
+        req->header.service_id = svc->service_id;
+
+        size = cmd->handler(recv, resp);
+        if (size > 0) {
+            chif_template_store(req, cmd, resp, size);
+            dbPrintf("%s_0x%04x: %d byte response template\n", svc->name, cmd->command, size);
+        }
+    }
+}
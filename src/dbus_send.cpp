@@ -41,8 +41,6 @@ static const std::map<int, std::string> phosphor_loglevel_map {
 #define PHOSPHOR_LOGGING_OBJECT_PATH     "/xyz/openbmc_project/logging"
 #define PHOSPHOR_LOGGING_INTERFACE_NAME  "xyz.openbmc_project.Logging.Create"
 
-sdbusplus::bus_t bus(sdbusplus::bus::new_default());
-
 void dbus_send(std::string message,
                      uint32_t evtClass,
                      uint32_t  evtCode,
@@ -52,6 +50,8 @@ void dbus_send(std::string message,
 {
     try
     {
+        // connect on first use, not at load time: the tools link this file too
+        static sdbusplus::bus_t bus(sdbusplus::bus::new_default());
         std::map<std::string, std::string> additionalData;
         additionalData["_PID"] = std::to_string(getpid());
         additionalData.emplace("CLASS", std::to_string(evtClass));
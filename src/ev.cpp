@@ -21,433 +21,1041 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#include <search.h>
 #include <stdint.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <atomic>
+#include <thread>
 #include <vector>
 #include <string>
-#include <fstream>
+#include "zlib.h"
 #include "ev.hpp"
+#include "reactor.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 #include "misc.hpp"
 
 #define UEFI_EVS_STORE "/usr/share/uefi/uefievs.store"
-#define EV_FILE "/home/root/evs.dat"
-#define EV_TMP  "/home/root/evs.tmp"
+#define EV_FILE CHIF_PATH("/home/root/evs.dat")
+#define EV_TMP  CHIF_PATH("/home/root/evs.tmp")     // left by the old rewrite
+#define EV_NEW  CHIF_PATH("/home/root/evs.new")     // a new log until it is renamed
 
+#define EV_REC_LEN(size)    ((long)sizeof(struct ev_rec) + (size))
+#define EV_MAP_SLACK        EV_FILE_MAX_SIZE    // mapped past the end for later appends
+
+int EVError;
 struct ev e;
 
-static struct node* new_node(void)
+static int log_fd = -1;
+static long log_end;            // everything before is valid records
+static uint32_t log_seq;        // of the next record
+static uint32_t log_gen;
+static int log_unsynced;        // records written since the last sync
+static long log_synced;         // end of the log the last sync covered
+static std::vector<uint8_t> log_window; // the records after log_synced, as written
+static bool log_sync_failed;    // log_fd lost writes, only a new log can hold them
+static long live_bytes;         // of the records the index points at
+static const uint8_t *log_map;  // evs.dat, read-only
+static size_t log_map_len;
+
+/*
+ * The index: the EVs in the order BIOS enumerates them (0x012b walks it by
+ * position), and an open addressing hash table of positions in that order
+ * for lookups by name (0x0130, sets and deletes).  Sets and lookups are
+ * O(1); a delete shifts the positions after it and rebuilds the table.
+ */
+struct ev_entry {
+        char name[EV_NAME_MAX_LEN];
+        long offset;            // of the struct ev_rec in evs.dat
+        int size;
+};
+
+#define EV_HASH_MIN     64      // slots, a power of 2 at least twice the EVs
+
+static std::vector<struct ev_entry> evs;
+static std::vector<int> ev_hash;        // position in evs, -1 for a free slot
+
+static uint32_t ev_name_hash(const char *name)
 {
-    struct node *n;
+    uint32_t h = 2166136261u;   // FNV-1a
+    int i;
 
-    n = (struct node *)malloc(sizeof(struct node));
+    for (i = 0; i < EV_NAME_MAX_LEN && name[i]; i++)
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    return h;
+}
 
-    if(n == NULL) {
-        dbPrintf("ev: new_entry(): malloc failed\n");
-        return NULL;
-    }
-    n->forward = NULL;
-    n->backward = NULL;
-    return n;
+/* slot of name, or the free slot where it would go */
+static uint32_t ev_slot(const char *name)
+{
+    uint32_t mask = ev_hash.size() - 1;
+    uint32_t i = ev_name_hash(name) & mask;
+
+    while (ev_hash[i] >= 0 && strncmp(evs[ev_hash[i]].name, name, EV_NAME_MAX_LEN))
+        i = (i + 1) & mask;
+    return i;
 }
 
-struct node *head = NULL;
+static void ev_rehash(void)
+{
+    size_t slots = EV_HASH_MIN;
+    size_t i;
+
+    while (slots < 2 * evs.size())
+        slots *= 2;
+    ev_hash.assign(slots, -1);
+    for (i = 0; i < evs.size(); i++)
+        ev_hash[ev_slot(evs[i].name)] = i;
+}
 
 void printEVs()
 {
-    struct node *n = head;
-    int size = 0;
-    while(n != NULL)
-    {
-        dbPrintf("EV: node: %s, offset: %lu\n", n->name, n->offset);
-        n = n->forward;
-        size++;
-    }
+    for (const struct ev_entry &n : evs)
+        dbPrintf("EV: node: %s, offset: %lu\n", n.name, n.offset);
 }
 
-int initEV(void)
+static struct ev_entry *ev_find(const char *name)
 {
-    struct ev e;
-    struct node *n;
-    struct node *prev_node = NULL;
-    FILE *fp;
-    long offset = 0;
-    size_t rc;
-    int i = 0;
+    int pos;
 
-    fp = fopen(EV_FILE, "a+");
+    if (ev_hash.empty())
+        return NULL;
+    pos = ev_hash[ev_slot(name)];
+    return pos < 0 ? NULL : &evs[pos];
+}
 
-    while(1) {
-        rc = fread(&e, sizeof(struct ev), 1, fp);
-        if(rc<1) {
-            break;
-        }
-        n = new_node();
-        if (!n) {
-            break;
-        }
-        if (head == NULL) {
-            dbPrintf("EV: Saving memory address of first node.\n");
-            head = n; //saves memory address of first node
-        }
-        if(prev_node !=NULL)
-            dbPrintf("EV: Prev Node: %s\n", prev_node->name);
+/* the index follows the log: a set keeps the position of the EV it replaces */
+static void ev_index_set(const char *name, long offset, int size)
+{
+    struct ev_entry *n = ev_find(name);
+    struct ev_entry ne;
+
+    if (n) {
+        live_bytes -= EV_REC_LEN(n->size);
+    } else {
+        memcpy(ne.name, name, sizeof(ne.name));
+        evs.push_back(ne);
+        if (evs.size() * 2 > ev_hash.size())
+            ev_rehash();
         else
-            dbPrintf("EV: Prev Node is NULL\n");
-        insque(n, prev_node);
+            ev_hash[ev_slot(name)] = evs.size() - 1;
+        n = &evs.back();
+    }
+    n->offset = offset;
+    n->size = size;
+    live_bytes += EV_REC_LEN(size);
+}
 
-        memcpy(n->name, e.name, sizeof(n->name));
-        dbPrintf("EV: found instance: %s\n", n->name);
-        n->offset = offset;
-        dbPrintf("EV: offset: %lu\n", n->offset);
-        prev_node = n;
-        offset += ( sizeof(struct ev) );
-        offset += e.size;
+static void ev_index_del(const char *name)
+{
+    struct ev_entry *n = ev_find(name);
 
-        fseek(fp, e.size, SEEK_CUR);
-        i++;
-    }
-    fclose(fp);
-    printEVs();
-    return 0;
+    if (!n)
+        return;
+    live_bytes -= EV_REC_LEN(n->size);
+    evs.erase(evs.begin() + (n - evs.data()));
+    ev_rehash();
 }
 
-int clearEV(void)
+static void ev_index_clear(void)
 {
-    FILE *fp;
+    evs.clear();
+    ev_hash.clear();
+    live_bytes = 0;
+}
 
-    head = NULL;
-    fp = fopen(EV_FILE, "w");
-    fsync(fileno(fp));
-    fclose(fp);
-    initEV();
-    return 0;
+static uint32_t ev_rec_crc(const struct ev_rec *r, const void *data)
+{
+    uLong crc = crc32(0L, Z_NULL, 0);
+
+    crc = crc32(crc, (const Bytef *)r + sizeof(r->crc), sizeof(*r) - sizeof(r->crc));
+    return crc32(crc, (const Bytef *)data, r->size);
 }
 
-static long getOffsetByIndex(int index)
+/* build a record in buf, its length */
+static long ev_rec_encode(uint8_t *buf, uint8_t type, uint32_t seq, const char *name,
+                          const void *data, int size)
 {
-    struct node *n;
-    long offset = -1;
-    int i = 0;
+    struct ev_rec *r = (struct ev_rec *)buf;
+
+    memset(r, 0, sizeof(*r));
+    r->seq = seq;
+    r->size = size;
+    r->type = type;
+    if (name)
+        memcpy(r->name, name, sizeof(r->name));
+    if (size)
+        memcpy(buf + sizeof(*r), data, size);
+    r->crc = ev_rec_crc(r, buf + sizeof(*r));
+    return EV_REC_LEN(size);
+}
 
-    n = head;
-    while(n!=NULL) {
-        if(i==index) {
-            offset = n->offset;
-            break;
-        }
-        n = n->forward;
-        i++;
+/* length of a valid record at p with at most len bytes, 0 when it is not one */
+static long ev_rec_check(const uint8_t *p, long len)
+{
+    const struct ev_rec *r = (const struct ev_rec *)p;
+
+    if (len < (long)sizeof(*r) || r->size > EV_DATA_MAX_LEN || len < EV_REC_LEN(r->size))
+        return 0;
+    if (r->type < EV_REC_SET || r->type > EV_REC_CLEAR)
+        return 0;
+    if (r->crc != ev_rec_crc(r, p + sizeof(*r)))
+        return 0;
+    return EV_REC_LEN(r->size);
+}
+
+static void ev_rec_apply(const struct ev_rec *r, long offset)
+{
+    switch (r->type) {
+    case EV_REC_SET:
+        ev_index_set(r->name, offset, r->size);
+        break;
+    case EV_REC_DEL:
+        ev_index_del(r->name);
+        break;
+    case EV_REC_CLEAR:
+        ev_index_clear();
+        break;
     }
+}
 
-    return offset;
+static int write_all(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    ssize_t n;
+
+    while (len) {
+        n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
 }
 
-static long getOffset(char *name)
+/* the first max bytes of the file on fd, all of it by default; -1 on a read error */
+static int read_file(int fd, std::vector<uint8_t> &buf, long max = LONG_MAX)
 {
-    struct node *n;
-    long offset = -1;
-    int i = 0;
+    struct stat st;
+    ssize_t n;
+    long got = 0;
 
-    n = head;
-    while(n!=NULL) {
-        // dbPrintf("EV: node(%d)= %s\n", i, n->name);
-        if(strcmp(n->name, name)==0) {
-            offset = n->offset;
+    if (fstat(fd, &st) < 0)
+        return -1;
+    if (st.st_size > max)
+        st.st_size = max;
+    buf.resize(st.st_size);
+    while (got < st.st_size) {
+        n = pread(fd, buf.data() + got, st.st_size - got, got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
             break;
-        }
-        n = n->forward;
-        i++;
+        got += n;
     }
-    dbPrintf("EV: offset found: %ld\n", offset);
-    return offset;
+    buf.resize(got);
+    return 0;
 }
 
-int getEVbyName(char *name, char *data, int data_len)
+/* write a whole log to path and sync it, the caller renames it into place */
+static int ev_write_new(const char *path, const std::vector<uint8_t> &img)
 {
-    long offset = 0;
-    struct ev e;
-    FILE *fp;
-    size_t rc;
+    int fd;
 
-    offset = getOffset(name);
-    if(offset<0) {
-        dbPrintf("EV: getEVByname: ev(%s) not found\n", name);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        printf("EV: cannot create %s: %s\n", path, strerror(errno));
         return -1;
     }
-
-    fp = fopen(EV_FILE, "r");
-    if(fp == NULL) {
-        dbPrintf("EV: getEVByName: evs.dat is not found\n");
-        return -2;
+    if (write_all(fd, img.data(), img.size()) < 0 || fsync(fd) < 0) {
+        printf("EV: cannot write %s: %s\n", path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return -1;
     }
+    close(fd);
+    return 0;
+}
 
-    fseek(fp, offset, SEEK_SET);
-    rc = fread(&e, sizeof(struct ev), 1, fp);
-    if(rc<1) {
-        dbPrintf("EV: getEVByname: fread: failed to get name & size\n");
-        fclose(fp);
-        return -3;
-    }
+/* make the renames in the directory of evs.dat durable */
+static void ev_sync_dir(void)
+{
+    std::string dir = EV_FILE;
+    int fd;
 
-    if(data_len < e.size) {
-        dbPrintf("EV: getEVByname: data size is too small\n");
-        fclose(fp);
-        return -4;
+    dir.erase(dir.rfind('/'));
+    fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || fsync(fd) < 0)
+        printf("EV: cannot sync %s: %s\n", dir.c_str(), strerror(errno));
+    if (fd >= 0)
+        close(fd);
+}
+
+/* rename a synced log at path over evs.dat, the one step that commits it */
+static int ev_install(const char *path)
+{
+    if (rename(path, EV_FILE) < 0) {
+        printf("EV: cannot rename %s to %s: %s\n", path, EV_FILE, strerror(errno));
+        return -1;
     }
+    ev_sync_dir();
+    return 0;
+}
+
+/* read up to max bytes of path into buf: 1, 0 when there is no such file, -1 */
+static int ev_load(const char *path, std::vector<uint8_t> &buf, long max = LONG_MAX)
+{
+    int fd, rc;
 
-    rc = fread(data, sizeof(char), e.size, fp);
-    if(rc!=e.size) {
-        dbPrintf("EV: getEVByname: fread: failed to get ev data\n");
-        fclose(fp);
-        return -5;
+    buf.clear();
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT)
+        return 0;
+    if (fd < 0) {
+        printf("EV: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
     }
+    rc = read_file(fd, buf, max);
+    if (rc < 0)
+        printf("EV: cannot read %s: %s\n", path, strerror(errno));
+    close(fd);
+    return rc < 0 ? -1 : 1;
+}
 
-    fclose(fp);
-    dbPrintf("EV: Size of EV: %d\n", e.size);
-    dbPrintf("EV: Name: %s\n", e.name);
-    dbPrintf("End EV Data\n");
-    return e.size;
+static bool ev_is_log(const std::vector<uint8_t> &img)
+{
+    return img.size() >= sizeof(struct ev_log_header) &&
+           !memcmp(img.data(), EV_LOG_MAGIC, sizeof(((struct ev_log_header *)0)->magic));
 }
 
-struct ev *getEVbyIndex(int index, char *data, int data_len)
+static void ev_log_header(std::vector<uint8_t> &img, uint32_t generation)
 {
-    long offset = 0;
-    FILE *fp;
-    size_t rc;
+    struct ev_log_header h;
 
-    offset = getOffsetByIndex(index);
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, EV_LOG_MAGIC, sizeof(h.magic));
+    h.version = EV_LOG_VERSION;
+    h.generation = generation;
+    img.assign((uint8_t *)&h, (uint8_t *)&h + sizeof(h));
+}
 
-    if(offset<0) {
-        dbPrintf("EV: getEVByIndex: ev(index=%d) not found\n", index);
-        EVError = -1;
-        return &e;
+static void ev_log_add(std::vector<uint8_t> &img, uint8_t type, uint32_t seq, const char *name,
+                       const void *data, int size)
+{
+    size_t at = img.size();
+
+    img.resize(at + EV_REC_LEN(size));
+    ev_rec_encode(img.data() + at, type, seq, name, data, size);
+}
+
+/* length of the old style EV at offset at of old, 0 when there is none */
+static long ev_legacy_next(const std::vector<uint8_t> &old, size_t at)
+{
+    struct ev le;
+
+    if (at + sizeof(le) > old.size())
+        return 0;
+    memcpy(&le, old.data() + at, sizeof(le));
+    // an empty name is the zeroed block of a write that never reached the disk
+    if (!le.name[0] || le.size > EV_DATA_MAX_LEN || at + sizeof(le) + le.size > old.size())
+        return 0;
+    return sizeof(le) + le.size;
+}
+
+/* EVs at the start of an old style file, *end is where the last one ends */
+static int ev_legacy_count(const std::vector<uint8_t> &old, size_t *end)
+{
+    size_t at = 0;
+    long len;
+    int n = 0;
+
+    while ((len = ev_legacy_next(old, at)) > 0) {
+        at += len;
+        n++;
     }
+    *end = at;
+    return n;
+}
 
-    fp = fopen(EV_FILE, "r");
-    if(fp == NULL) {
-        dbPrintf("EV: getEVByIndex: evs.dat is not found\n");
-        EVError = -2;
-        return &e;
+/* ev_import_legacy()
+ *
+ * An evs.dat from before the log is a plain run of struct ev and data, in
+ * the order BIOS enumerates them.  Rewritten as a log of sets in evs.dat.
+ */
+static int ev_import_legacy(const std::vector<uint8_t> &old, const char *from)
+{
+    std::vector<uint8_t> img;
+    struct ev le;
+    size_t at = 0;
+    uint32_t seq = 0;
+    long len;
+
+    ev_log_header(img, 0);
+    while ((len = ev_legacy_next(old, at)) > 0) {
+        memcpy(&le, old.data() + at, sizeof(le));
+        ev_log_add(img, EV_REC_SET, seq++, le.name, old.data() + at + sizeof(le), le.size);
+        at += len;
     }
+    printf("EV: converting %u EVs of %s to a log\n", seq, from);
+    if (ev_write_new(EV_NEW, img) < 0 || ev_install(EV_NEW) < 0)
+        return -1;
+    return 0;
+}
 
-    fseek(fp, offset, SEEK_SET);
-    rc = fread(&e, sizeof(struct ev), 1, fp);
-    if(rc<1) {
-        dbPrintf("EV: getEVByIndex: fread: failed to get name & size\n");
-        fclose(fp);
-        EVError = -3;
-        return &e;
+/* ev_recover()
+ *
+ * Leave a log at evs.dat before it is opened, whatever a crash left next
+ * to it:
+ *  - evs.dat is a log: it is what was committed, a rename is atomic.  An
+ *    evs.new is a compaction or conversion that never got renamed.
+ *  - no evs.dat, but a log in evs.new: creating or converting the log got
+ *    as far as syncing evs.new, it is renamed into place.
+ *  - evs.tmp: the old rewrite renamed evs.dat to evs.tmp, wrote a new
+ *    evs.dat without syncing it and removed evs.tmp.  The new evs.dat is
+ *    converted only when it is complete, valid EVs up to its end and at
+ *    least as many as evs.tmp has; otherwise evs.tmp is, which undoes a
+ *    delete caught before evs.tmp was removed.
+ *  - an old style evs.dat is converted, and nothing at all is a first boot.
+ * Any of them that cannot be read stops it: nothing is replaced on a guess.
+ */
+static int ev_recover(void)
+{
+    std::vector<uint8_t> dat, tmp, img;
+    int has_dat, has_tmp, has_new, dat_evs, tmp_evs;
+    size_t dat_end, tmp_end;
+
+    has_dat = ev_load(EV_FILE, dat, sizeof(struct ev_log_header));
+    if (has_dat < 0)
+        return -1;
+    if (has_dat && ev_is_log(dat)) {
+        unlink(EV_NEW);
+        unlink(EV_TMP);
+        return 0;
     }
 
-    if(data_len < e.size) {
-        dbPrintf("EV: getEVByIndex: data size is too small\n");
-        fclose(fp);
-        EVError = -4;
-        return &e;
+    has_tmp = ev_load(EV_TMP, tmp);
+    has_new = ev_load(EV_NEW, img, sizeof(struct ev_log_header));
+    if (has_tmp < 0 || has_new < 0 || (has_dat && ev_load(EV_FILE, dat) < 0))
+        return -1;
+
+    if (!has_dat && has_new && ev_is_log(img)) {
+        printf("EV: %s was not renamed to %s, using it\n", EV_NEW, EV_FILE);
+        if (ev_install(EV_NEW) < 0)
+            return -1;
+    } else if (has_tmp) {
+        dat_evs = ev_legacy_count(dat, &dat_end);
+        tmp_evs = ev_legacy_count(tmp, &tmp_end);
+        if (has_dat && dat_end == dat.size() && dat_evs >= tmp_evs) {
+            if (ev_import_legacy(dat, EV_FILE) < 0)
+                return -1;
+        } else {
+            printf("EV: %s is incomplete, recovering %d EVs from %s\n", EV_FILE, tmp_evs,
+                   EV_TMP);
+            if (ev_import_legacy(tmp, EV_TMP) < 0)
+                return -1;
+        }
+    } else if (has_dat && !dat.empty()) {
+        if (ev_import_legacy(dat, EV_FILE) < 0)
+            return -1;
+    } else {
+        ev_log_header(img, 0);
+        if (ev_write_new(EV_NEW, img) < 0 || ev_install(EV_NEW) < 0)
+            return -1;
     }
+    unlink(EV_NEW);
+    unlink(EV_TMP);
+    return 0;
+}
 
-    rc = fread(data, sizeof(char), e.size, fp);
-    if(rc!=e.size) {
-        dbPrintf("EV: getEVByIndex: fread: failed to get ev data\n");
-        fclose(fp);
-        EVError = -5;
-        return &e;
+/* ev_scan()
+ *
+ * Rebuild the index from the log on log_fd.  The log is the longest run of
+ * records from the header that are whole, pass their checksum and number
+ * on from 0 without a gap; the first that does not is a write cut by a
+ * crash, and it and everything after it are cut off so new records are not
+ * appended behind them.
+ */
+static int ev_scan(void)
+{
+    std::vector<uint8_t> img;
+    const struct ev_log_header *h;
+    const struct ev_rec *r;
+    long at, len;
+
+    ev_index_clear();
+    if (read_file(log_fd, img) < 0 || !ev_is_log(img)) {
+        printf("EV: %s is not an EV log\n", EV_FILE);
+        return -1;
+    }
+    h = (const struct ev_log_header *)img.data();
+    if (h->version != EV_LOG_VERSION) {
+        printf("EV: %s is version %u of the log, not %u\n", EV_FILE, h->version,
+               EV_LOG_VERSION);
+        return -1;
     }
+    log_gen = h->generation;
+    log_seq = 0;
 
-    fclose(fp);
-    EVError = e.size;
-    return &e;
+    at = sizeof(*h);
+    while ((len = ev_rec_check(img.data() + at, img.size() - at)) > 0) {
+        r = (const struct ev_rec *)(img.data() + at);
+        if (r->seq != log_seq)
+            break;
+        ev_rec_apply(r, at);
+        log_seq++;
+        at += len;
+    }
+    if (at != (long)img.size()) {
+        printf("EV: %s: dropping %ld bytes after record %u\n", EV_FILE, (long)img.size() - at,
+               log_seq);
+        CHIF_TRACE("ev recover %u records, %ld bytes dropped", log_seq, (long)img.size() - at);
+        if (ftruncate(log_fd, at) < 0 || fsync(log_fd) < 0)
+            return -1;
+    }
+    log_end = at;
+    log_synced = at;
+    log_window.clear();
+    log_sync_failed = false;
+    return 0;
 }
 
-int setEV(char *name, char *data, int data_len)
+/* ev_map()
+ *
+ * Map evs.dat for the readers.  Appends go through log_fd and show up in
+ * the shared mapping, which covers EV_MAP_SLACK past the end so that it
+ * only has to be redone when the log outgrows it or is replaced.  Only
+ * offsets below log_end are ever read.
+ */
+static int ev_map(void)
 {
-    int read_size;
-    struct ev e;
-    struct node *n;
-    struct node *n_last;
-    FILE *fp;
-    FILE *fp_tmp;
-    char buf[EV_DATA_MAX_LEN];
-    char new_ev = 1;
-
-    rename(EV_FILE, EV_TMP);
-    fp_tmp = fopen(EV_TMP, "r");
-
-    fp = fopen(EV_FILE, "w");
-    if(fp == NULL) {
-        dbPrintf("setEV: failed to open evs.dat, retrying...\n");
-        sleep(1);
-        fp = fopen(EV_FILE, "w");
-        if(fp == NULL) {
-            dbPrintf("setEV: failed to create new evs.dat\n");
-            return -1;
-        }
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t len;
+    void *p;
+
+    if (log_map && (size_t)log_end <= log_map_len)
+        return 0;
+    if (log_map)
+        munmap((void *)log_map, log_map_len);
+    log_map = NULL;
+    if (log_fd < 0)
+        return -1;
+
+    len = (log_end + EV_MAP_SLACK + page - 1) & ~(page - 1);
+    p = mmap(NULL, len, PROT_READ, MAP_SHARED, log_fd, 0);
+    if (p == MAP_FAILED) {
+        printf("EV: cannot map %s: %s\n", EV_FILE, strerror(errno));
+        return -1;
     }
+    log_map = (const uint8_t *)p;
+    log_map_len = len;
+    return 0;
+}
 
-    n = head;
-    n_last = n;
-
-    while(n!=NULL) {
-        fseek(fp_tmp, n->offset, SEEK_SET); //move to next ev entry
-        n->offset = ftell(fp); //update offset to the value of new evs file;
-        if(strncmp(n->name, name, EV_NAME_MAX_LEN)) {
-            //save the ev which is not matched
-            read_size = fread(&e, sizeof(struct ev), 1, fp_tmp);    //name
-            if(read_size<=0) {
-                dbPrintf("EV Size is less than 0... %s %ld \n", n->name, n->offset);
-                exit(0);
-            }
-            fwrite(&e, sizeof(struct ev), 1, fp);
-
-            if ( e.size > 0 )
-            {
-                read_size = fread(buf, sizeof(char), e.size, fp_tmp);   //data
-                if(read_size<=0) {
-                    dbPrintf("EV Data is less than 0... %s %ld \n", n->name, n->offset);
-                }
-                else
-                    fwrite(buf, sizeof(char), e.size, fp);
-            }
-        }
-        else {
-            //replace ev and save ev to tmp file.
-            memcpy(e.name, name, sizeof(e.name));
-            e.size = data_len;
-            fwrite(&e, sizeof(struct ev), 1, fp);
+static void ev_unmap(void)
+{
+    if (log_map)
+        munmap((void *)log_map, log_map_len);
+    log_map = NULL;
+    log_map_len = 0;
+}
 
-            memcpy(buf, data, data_len < (int)sizeof(buf) ? data_len : sizeof(buf));
-            fwrite(buf, sizeof(char), data_len, fp);
+/* the data of an EV: not synced yet from log_window, else from the mapping */
+static const uint8_t *ev_data(const struct ev_entry *n)
+{
+    if (n->offset >= log_synced)
+        return log_window.data() + (n->offset - log_synced) + sizeof(struct ev_rec);
+    if (ev_map() < 0)
+        return NULL;
+    return log_map + n->offset + sizeof(struct ev_rec);
+}
+
+/* copy the data of an EV to data, its size or the error of getEVbyName() */
+static int ev_read(const struct ev_entry *n, char *data, int data_len)
+{
+    const uint8_t *p;
+
+    if (data_len < n->size)
+        return -4;
+    p = ev_data(n);
+    if (!p)
+        return -2;
+    memcpy(data, p, n->size);
+    return n->size;
+}
 
-            new_ev = 0; //clear the new_ev flag
+/*
+ * Compaction: a thread copies the live records of the log as it was
+ * (log_end at the start, that part never changes) to evs.new.  The event
+ * loop then appends what was logged in the meantime, renames evs.new over
+ * evs.dat and switches to it.
+ */
+static struct {
+    std::thread thread;
+    std::atomic<int> state{0};
+    int fd;                     // old log
+    long end;                   // of the part copied
+    std::vector<long> offsets;  // of the live records, in index order
+    uint32_t generation;
+    uint32_t seq;               // of the next record in evs.new
+} compact;
+
+enum { COMPACT_IDLE, COMPACT_RUNNING, COMPACT_DONE, COMPACT_FAILED };
+
+static void ev_compact_thread(void)
+{
+    std::vector<uint8_t> img;
+    uint8_t rec[sizeof(struct ev_rec) + EV_DATA_MAX_LEN];
+    const struct ev_rec *r = (const struct ev_rec *)rec;
+    uint32_t seq = 0;
+    ssize_t n;
+
+    ev_log_header(img, compact.generation);
+    for (long off : compact.offsets) {
+        n = pread(compact.fd, rec, sizeof(rec), off);
+        if (n <= 0 || ev_rec_check(rec, n) <= 0) {
+            compact.state = COMPACT_FAILED;
+            return;
         }
-        n_last = n;
-        n = n->forward;
-    }
-
-    if(new_ev) {
-        n = new_node();
-        if (n) {
-            n->offset = ftell(fp);
-            memcpy(n->name, name, sizeof(n->name));
-            if(n_last == NULL) {
-                head = n;
-            }
-            else {
-                insque(n, n_last);
-            }
-
-            e.size = data_len;
-            memcpy(e.name, name, sizeof(e.name));
-            fwrite(&e, sizeof(struct ev), 1, fp);
-            fwrite(data, sizeof(char), data_len, fp);
+        ev_log_add(img, EV_REC_SET, seq++, r->name, rec + sizeof(*r), r->size);
+    }
+    compact.seq = seq;
+    compact.state = ev_write_new(EV_NEW, img) < 0 ? COMPACT_FAILED : COMPACT_DONE;
+}
+
+static void ev_compact_start(void)
+{
+    if (compact.state != COMPACT_IDLE || log_sync_failed)
+        return;
+    if (log_end - (long)sizeof(struct ev_log_header) - live_bytes < EV_COMPACT_MIN_DEAD ||
+        log_end - (long)sizeof(struct ev_log_header) - live_bytes < live_bytes)
+        return;
+
+    compact.fd = log_fd;
+    compact.end = log_end;
+    compact.generation = log_gen + 1;
+    compact.offsets.clear();
+    for (const struct ev_entry &n : evs)
+        compact.offsets.push_back(n.offset);
+    dbPrintf("EV: compacting %ld bytes, %ld live\n", log_end, live_bytes);
+    compact.state = COMPACT_RUNNING;
+    compact.thread = std::thread(ev_compact_thread);
+}
+
+/* ev_compact_finish()
+ *
+ * Switch to the compacted log once the thread is done, with wait block
+ * until it is.  Event loop only, like every other EV routine.
+ */
+static void ev_compact_finish(bool wait)
+{
+    std::vector<uint8_t> tail;
+    uint8_t rec[sizeof(struct ev_rec) + EV_DATA_MAX_LEN];
+    const struct ev_rec *r;
+    long at, len, n;
+    int fd;
+
+    if (compact.state == COMPACT_IDLE || (!wait && compact.state == COMPACT_RUNNING))
+        return;
+    compact.thread.join();
+    if (compact.state == COMPACT_FAILED)
+        goto fail;
+
+    fd = open(EV_NEW, O_RDWR | O_APPEND | O_CLOEXEC);
+    if (fd < 0)
+        goto fail;
+
+    // records logged while the thread ran, renumbered after the copied ones
+    if (read_file(log_fd, tail) < 0) {
+        close(fd);
+        goto fail;
+    }
+    at = compact.end;
+    while ((len = ev_rec_check(tail.data() + at, log_end - at)) > 0) {
+        r = (const struct ev_rec *)(tail.data() + at);
+        n = ev_rec_encode(rec, r->type, compact.seq++, r->name, tail.data() + at + sizeof(*r),
+                          r->size);
+        if (write_all(fd, rec, n) < 0) {
+            close(fd);
+            goto fail;
         }
+        at += len;
+    }
+    if ((compact.end != log_end && fsync(fd) < 0) || ev_install(EV_NEW) < 0) {
+        close(fd);
+        goto fail;
     }
 
-    fsync(fileno(fp));
-    fclose(fp);
+    ev_unmap();
+    close(log_fd);
+    log_fd = fd;
+    log_unsynced = 0;           // all of it was synced in evs.new
+    ev_scan();
+    dbPrintf("EV: compacted to %ld bytes, generation %u\n", log_end, log_gen);
+    compact.state = COMPACT_IDLE;
+    return;
+
+fail:
+    printf("EV: compaction failed, keeping %s\n", EV_FILE);
+    unlink(EV_NEW);
+    compact.state = COMPACT_IDLE;
+}
 
-    fclose(fp_tmp);
-    remove(EV_TMP);
+/*
+ * Group commit: a record is written to evs.dat right away, and copied to
+ * log_window for reads and a rewrite, but synced only when the commit timer
+ * fires commit_ms after the first record that is not synced yet.  Records
+ * of the names in EV_SYNC_CONF, deletes of everything, and all records when
+ * there is no event loop to run the timer or after a sync failed are synced
+ * before the response.
+ */
+static unsigned int commit_ms = EV_COMMIT_MS;
+static int commit_timer = -1;
+static bool commit_armed;
+static bool commit_no_timer;    // no event loop, sync every record
+static bool commit_failed;      // a sync failed this boot, sync every record
+static std::vector<std::string> sync_names;
+
+static void ev_commit_event(int timer, void *ctx)
+{
+    (void)timer;
+    (void)ctx;
 
-    return 0;
+    commit_armed = false;
+    ev_compact_finish(false);
+    flushEV();
 }
 
-int delEV(char *name)
+/* start the commit window if it is not running, false when it cannot be */
+static bool ev_commit_arm(void)
+{
+    if (commit_armed)
+        return true;
+    if (commit_timer < 0 && !commit_no_timer) {
+        commit_timer = reactor_add_timer(0, 0, ev_commit_event, NULL);
+        commit_no_timer = commit_timer < 0;
+    }
+    if (commit_no_timer || reactor_arm_timer(commit_timer, commit_ms, 0) < 0)
+        return false;
+    commit_armed = true;
+    return true;
+}
+
+static bool ev_sync_name(const char *name)
+{
+    size_t len;
+
+    for (const std::string &s : sync_names) {
+        len = s.size();
+        if (len && s[len - 1] == '*') {
+            if (strncmp(name, s.c_str(), len - 1) == 0)
+                return true;
+        } else if (strncmp(name, s.c_str(), EV_NAME_MAX_LEN) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ev_sync_load(void)
 {
-    long offset = 0;
-    int read_size;
-    struct ev e;
-    struct node *n;
-    struct node *n_tmp = NULL;
+    char line[128];
     FILE *fp;
-    FILE *fp_tmp;
-    char buf[EV_DATA_MAX_LEN];
 
-    offset = getOffset(name);
-    if(offset<0) {
-        dbPrintf("delEV: ev(%s) not found\n", name);
-        return 0;
+    sync_names.clear();
+    fp = fopen(CHIF_PATH(EV_SYNC_CONF), "r");
+    if (!fp)
+        return;
+    while (fgets(line, sizeof(line), fp)) {
+        char *name = strtok(line, " \t\r\n");
+
+        if (name && *name != '#')
+            sync_names.push_back(name);
     }
+    fclose(fp);
+    dbPrintf("EV: %zu names synced on every set\n", sync_names.size());
+}
 
-    //the evs.dat must exist 
-    rename(EV_FILE, EV_TMP);
-    fp_tmp = fopen(EV_TMP, "r");
+void setEVCommitWindow(unsigned int window_ms)
+{
+    commit_ms = window_ms;
+}
+
+/* ev_rewrite()
+ *
+ * A failed sync says nothing about which of the records written since the
+ * last good one reached the disk, and the kernel may have dropped their
+ * pages already; syncing log_fd again would succeed without them.  So the
+ * live EVs are written to a new log like a compaction does, those of the
+ * window from log_window and the older ones from the mapping, and that is
+ * renamed over evs.dat.  A compaction in flight read the old log and is
+ * thrown away.  When this fails too, the window stays in memory and the
+ * next sync tries again.
+ */
+static int ev_rewrite(void)
+{
+    std::vector<uint8_t> img;
+    const uint8_t *p;
+    uint32_t seq = 0;
+    int fd;
 
-    fp = fopen(EV_FILE, "w");
-    if(fp == NULL) {
-        dbPrintf("delEV: failed to create new evs.dat\n");
+    if (compact.state != COMPACT_IDLE) {
+        compact.thread.join();
+        unlink(EV_NEW);
+        compact.state = COMPACT_IDLE;
+    }
+
+    ev_log_header(img, log_gen + 1);
+    for (const struct ev_entry &n : evs) {
+        p = ev_data(&n);
+        if (!p)
+            return -1;
+        ev_log_add(img, EV_REC_SET, seq++, n.name, p, n.size);
+    }
+    if (ev_write_new(EV_NEW, img) < 0)
+        return -1;
+    fd = open(EV_NEW, O_RDWR | O_APPEND | O_CLOEXEC);
+    if (fd < 0 || ev_install(EV_NEW) < 0) {
+        if (fd >= 0)
+            close(fd);
+        unlink(EV_NEW);
+        return -1;
+    }
+
+    ev_unmap();
+    close(log_fd);
+    log_fd = fd;
+    log_unsynced = 0;
+    if (ev_scan() < 0) {
+        close(log_fd);
+        log_fd = -1;
         return -1;
     }
-    
-    n = head;
-    offset = 0;
-
-    while(n!=NULL) {
-        fseek(fp_tmp, n->offset, SEEK_SET);
-        n->offset = ftell(fp); //update offset to the value of new evs file;
-        if(strcmp(n->name, name)) {
-            //save ev which is not matched
-            read_size = fread(&e, sizeof(struct ev), 1, fp_tmp);    //name
-            if(read_size<=0) {
-                dbPrintf("EV Size is less than 0...\n");
-            }
-            fwrite(&e, sizeof(struct ev), 1, fp);
-
-            read_size = fread(buf, sizeof(char), e.size, fp_tmp);   //data
-            if(read_size<=0) {
-                dbPrintf("EV Size is less than 0...\n");
-            }
-            fwrite(buf, sizeof(char), e.size, fp);
+    printf("EV: rewrote %s with %zu EVs, generation %u\n", EV_FILE, evs.size(), log_gen);
+    return 0;
+}
+
+/* sync the commit window: 1, 0 when it went to a rewritten log instead, -1 */
+static int ev_sync(void)
+{
+    uint64_t t0;
+
+    if (!log_unsynced || log_fd < 0)
+        return 1;
+    t0 = stats_now_ns();
+    if (!log_sync_failed && fsync(log_fd) < 0) {
+        printf("EV: cannot sync %s: %s, syncing every record from now on\n", EV_FILE,
+               strerror(errno));
+        CHIF_TRACE("ev sync failed %d records", log_unsynced);
+        log_sync_failed = true;
+        commit_failed = true;
+    }
+    if (log_sync_failed) {
+        if (ev_rewrite() < 0) {
+            printf("EV: %d records of %s are only in memory\n", log_unsynced, EV_FILE);
+            return -1;
+        }
+        return 0;
+    }
+    CHIF_TRACE("ev commit %d records %llu ns", log_unsynced,
+               (unsigned long long)(stats_now_ns() - t0));
+    log_unsynced = 0;
+    log_synced = log_end;
+    log_window.clear();
+    return 1;
+}
+
+int flushEV(void)
+{
+    return ev_sync() < 0 ? -1 : 0;
+}
+
+/* ev_append()
+ *
+ * Append a record, synced or in the commit window, its offset or -1.  The
+ * caller updates the index after, so a log rewritten by a failed sync does
+ * not have this record and it is written once more to the new one.
+ */
+static long ev_append(uint8_t type, const char *name, const void *data, int size)
+{
+    uint8_t rec[sizeof(struct ev_rec) + EV_DATA_MAX_LEN];
+    long len, offset;
+    int tries, rc;
+
+    for (tries = 0; tries < 2; tries++) {
+        if (log_fd < 0)
+            return -1;
+        offset = log_end;
+        len = ev_rec_encode(rec, type, log_seq, name, data, size);
+        if (write_all(log_fd, rec, len) < 0) {
+            printf("EV: cannot append to %s: %s\n", EV_FILE, strerror(errno));
+            // a torn record would hide everything appended after it
+            if (ftruncate(log_fd, offset) < 0)
+                printf("EV: cannot truncate %s: %s\n", EV_FILE, strerror(errno));
+            return -1;
         }
-        else {
-            //skip ev
-            n_tmp = n;
+        log_window.insert(log_window.end(), rec, rec + len);
+        log_end += len;
+        log_seq++;
+        log_unsynced++;
+
+        if (commit_ms && !commit_failed && type != EV_REC_CLEAR &&
+            !(name && ev_sync_name(name)) && ev_commit_arm())
+            return offset;
+        rc = ev_sync();
+        if (rc > 0)
+            return offset;
+        if (rc < 0) {
+            // only this record is taken back, the rest of the window stays
+            if (ftruncate(log_fd, offset) < 0)
+                printf("EV: cannot truncate %s: %s\n", EV_FILE, strerror(errno));
+            log_window.resize(offset - log_synced);
+            log_end = offset;
+            log_seq--;
+            log_unsynced--;
+            return -1;
         }
-        n = n->forward;
     }
+    return -1;
+}
 
-    if (n_tmp) {
-        remque(n_tmp); //remove del ev from head
+int initEV(void)
+{
+    closeEV();
+    ev_sync_load();
+
+    if (ev_recover() < 0) {
+        printf("EV: cannot recover %s, EVs are not available\n", EV_FILE);
+        return -1;
     }
 
-    fsync(fileno(fp));
-    fclose(fp);
+    log_fd = open(EV_FILE, O_RDWR | O_APPEND | O_CLOEXEC);
+    if (log_fd < 0) {
+        printf("EV: cannot open %s: %s\n", EV_FILE, strerror(errno));
+        return -1;
+    }
+    if (ev_scan() < 0) {
+        close(log_fd);
+        log_fd = -1;
+        return -1;
+    }
+    dbPrintf("EV: %zu EVs, %ld of %ld bytes live\n", evs.size(), live_bytes, log_end);
+    printEVs();
+    return 0;
+}
 
-    fclose(fp_tmp);
-    remove(EV_TMP);
+void closeEV(void)
+{
+    ev_compact_finish(true);
+    flushEV();
+    ev_index_clear();
+    ev_unmap();
+    if (log_fd >= 0)
+        close(log_fd);
+    log_fd = -1;
+}
 
+int clearEV(void)
+{
+    ev_compact_finish(false);
+    if (ev_append(EV_REC_CLEAR, NULL, NULL, 0) < 0)
+        return -1;
+    ev_index_clear();
+    ev_compact_start();
     return 0;
 }
 
-int getNumOfAllEV(void)
+int getEVbyName(char *name, char *data, int data_len)
 {
-    struct node *n;
-    int i = 0;
+    struct ev_entry *n;
+    int rc;
 
-    n = head;
-    while(n!=NULL) {
-        i++;
-        n = n->forward;
+    ev_compact_finish(false);
+    n = ev_find(name);
+    if (!n) {
+        dbPrintf("EV: getEVByname: ev(%s) not found\n", name);
+        return -1;
     }
 
-    return i;
+    rc = ev_read(n, data, data_len);
+    if (rc < 0) {
+        dbPrintf("EV: getEVByname: ev(%s) cannot be read: %d\n", name, rc);
+        return rc;
+    }
+    dbPrintf("EV: Size of EV: %d\n", n->size);
+    dbPrintf("EV: Name: %s\n", n->name);
+    return rc;
 }
 
-int getSizeOfEVfile(void)
+struct ev *getEVbyIndex(int index, char *data, int data_len)
 {
-    struct stat buf;
-    int fd;
+    struct ev_entry *n;
 
-    fd = open(EV_FILE, O_RDONLY);
-    if(fd<0) {
-        return 0;
+    ev_compact_finish(false);
+    if (index < 0 || index >= (int)evs.size()) {
+        dbPrintf("EV: getEVByIndex: ev(index=%d) not found\n", index);
+        EVError = -1;
+        return &e;
     }
 
-    if(fstat(fd, &buf)<0) {
+    n = &evs[index];
+    e.size = n->size;
+    memcpy(e.name, n->name, sizeof(e.name));
+    EVError = ev_read(n, data, data_len);
+    if (EVError < 0)
+        dbPrintf("EV: getEVByIndex: ev(index=%d) cannot be read: %d\n", index, EVError);
+    return &e;
+}
+
+/* setEV()
+ *
+ * One record appended, whatever the size of the store.  It is synced at
+ * the end of the commit window, or before the return for the names in
+ * EV_SYNC_CONF, with a window of 0, without an event loop and after a
+ * sync failed.
+ */
+int setEV(char *name, char *data, int data_len)
+{
+    long offset;
+
+    if (data_len < 0 || data_len > EV_DATA_MAX_LEN)
+        return -1;
+    ev_compact_finish(false);
+    offset = ev_append(EV_REC_SET, name, data, data_len);
+    if (offset < 0)
+        return -1;
+    ev_index_set(name, offset, data_len);
+    ev_compact_start();
+    return 0;
+}
+
+int delEV(char *name)
+{
+    ev_compact_finish(false);
+    if (!ev_find(name)) {
+        dbPrintf("delEV: ev(%s) not found\n", name);
         return 0;
     }
+    if (ev_append(EV_REC_DEL, name, NULL, 0) < 0)
+        return -1;
+    ev_index_del(name);
+    ev_compact_start();
+    return 0;
+}
+
+int getNumOfAllEV(void)
+{
+    return evs.size();
+}
 
-    return buf.st_size;
+int getSizeOfEVfile(void)
+{
+    return live_bytes - (long)evs.size() * (long)(sizeof(struct ev_rec) - sizeof(struct ev));
 }
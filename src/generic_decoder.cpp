@@ -28,7 +28,7 @@
 extern "C" {
 #include "DataExtract.h"
 }
-extern void dbPrintf(const char *format, ...);
+#include "misc.hpp"
 
 // Decode functions
 UINT8 generic_decode(int, EVT_LOG_ENTRY*, EVT_DECODED_LOG_ENTRY*, UINT8);
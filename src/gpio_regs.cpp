@@ -0,0 +1,477 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "chif.hpp"
+#include "gpio_regs.hpp"
+#include "reactor.hpp"
+#include "trace.hpp"
+#include "misc.hpp"
+
+#define GPIO_REGS_CONSUMER  "chif"
+
+/* one register byte, bit i of val is line[i] of the request */
+struct gpio_byte {
+    int fd;                 // line request, -1 when the byte has no lines
+    uint8_t nlines;
+    uint8_t bit[8];         // register bit of each requested line
+    uint32_t offset[8];     // and its offset on the chip
+    uint8_t val;            // snapshot
+    bool valid;             // val was read since the last failure
+    bool edges;             // GPI with edge events, no polling needed
+    uint8_t en, st;         // GPI interrupt enable, latched status
+};
+
+static struct gpio_byte gpi[GPIO_REGS_GPI_BYTES];
+static struct gpio_byte gpo[GPIO_REGS_GPO_BYTES];
+static struct gpio_byte memid[GPIO_REGS_MEMID_BYTES];
+static bool bytes_init;
+
+static struct {
+    int fd;
+    bool watched;           // sysfs_notify() on a change
+    bool valid;
+    unsigned long val;
+} xreg = { -1, false, false, 0 };
+
+static int refresh_timer = -1;
+
+static struct gpio_byte *gpio_byte_find(int bank, uint32_t index)
+{
+    switch (bank) {
+    case GPIO_REGS_GPI:
+        return index < GPIO_REGS_GPI_BYTES ? &gpi[index] : NULL;
+    case GPIO_REGS_GPO:
+        return index < GPIO_REGS_GPO_BYTES ? &gpo[index] : NULL;
+    case GPIO_REGS_MEMID:
+        return index < GPIO_REGS_MEMID_BYTES ? &memid[index] : NULL;
+    default:
+        return NULL;
+    }
+}
+
+static void gpio_bytes_init(void)
+{
+    uint32_t i;
+
+    if (bytes_init)
+        return;
+    for (i = 0; i < GPIO_REGS_GPI_BYTES; i++)
+        gpi[i].fd = -1;
+    for (i = 0; i < GPIO_REGS_GPO_BYTES; i++)
+        gpo[i].fd = -1;
+    for (i = 0; i < GPIO_REGS_MEMID_BYTES; i++)
+        memid[i].fd = -1;
+    bytes_init = true;
+}
+
+/* read the lines of b into its snapshot, 0 or -EIO */
+static int gpio_byte_read(struct gpio_byte *b)
+{
+    struct gpio_v2_line_values lv;
+    uint8_t val = 0;
+    int i;
+
+    memset(&lv, 0, sizeof(lv));
+    lv.mask = (1ull << b->nlines) - 1;
+    if (ioctl(b->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lv) < 0) {
+        dbPrintf("gpio_regs: get values: %s\n", strerror(errno));
+        b->valid = false;
+        return -EIO;
+    }
+    for (i = 0; i < b->nlines; i++)
+        if (lv.bits & (1ull << i))
+            val |= 1 << b->bit[i];
+    b->val = val;
+    b->valid = true;
+    return 0;
+}
+
+/* refresh a GPI byte, changed bits that are enabled latch the status */
+static void gpi_refresh(uint32_t index)
+{
+    struct gpio_byte *b = &gpi[index];
+    uint8_t old = b->val;
+    bool was_valid = b->valid;
+
+    if (gpio_byte_read(b) < 0 || !was_valid)
+        return;
+    if ((old ^ b->val) & b->en) {
+        b->st |= (old ^ b->val) & b->en;
+        CHIF_TRACE("gpio gpi %u 0x%02x status 0x%02x", index, b->val, b->st);
+    }
+}
+
+static void gpi_event(int fd, uint32_t events, void *ctx)
+{
+    uint32_t index = (uint32_t)(uintptr_t)ctx;
+    struct gpio_byte *b = &gpi[index];
+    struct gpio_v2_line_event ev[16];
+    uint8_t edge = 0;
+    ssize_t n;
+    int i, j;
+
+    (void)events;
+
+    // the edges say which bits moved even if they have settled back since
+    while ((n = read(fd, ev, sizeof(ev))) > 0) {
+        for (i = 0; i < n / (ssize_t)sizeof(ev[0]); i++)
+            for (j = 0; j < b->nlines; j++)
+                if (ev[i].offset == b->offset[j])
+                    edge |= 1 << b->bit[j];
+    }
+    gpio_byte_read(b);
+    if (edge & b->en) {
+        b->st |= edge & b->en;
+        CHIF_TRACE("gpio gpi %u 0x%02x status 0x%02x", index, b->val, b->st);
+    }
+}
+
+/* read the server ID register into the snapshot, 0 or -EIO */
+static int xreg_read(void)
+{
+    char temp[64];
+    ssize_t n;
+
+    if (xreg.fd < 0) {
+        xreg.fd = open(CHIF_PATH(GPIO_XREG_SERVER_ID), O_RDONLY | O_CLOEXEC);
+        if (xreg.fd < 0) {
+            dbPrintf("gpio_regs: cannot open %s: %s\n", CHIF_PATH(GPIO_XREG_SERVER_ID),
+                     strerror(errno));
+            xreg.valid = false;
+            return -EIO;
+        }
+    }
+
+    // sysfs attributes are re-read from offset 0
+    n = pread(xreg.fd, temp, sizeof(temp) - 1, 0);
+    if (n <= 0) {
+        xreg.valid = false;
+        return -EIO;
+    }
+    temp[n] = '\0';
+    xreg.val = strtoul(temp, NULL, 16);
+    xreg.valid = true;
+    return 0;
+}
+
+static void xreg_event(int fd, uint32_t events, void *ctx)
+{
+    (void)fd;
+    (void)events;
+    (void)ctx;
+
+    xreg_read();
+}
+
+static void gpio_refresh(int timer, void *ctx)
+{
+    uint32_t i;
+
+    (void)timer;
+    (void)ctx;
+
+    for (i = 0; i < GPIO_REGS_GPI_BYTES; i++)
+        if (gpi[i].fd >= 0 && !gpi[i].edges)
+            gpi_refresh(i);
+    for (i = 0; i < GPIO_REGS_GPO_BYTES; i++)
+        if (gpo[i].fd >= 0)
+            gpio_byte_read(&gpo[i]);
+    for (i = 0; i < GPIO_REGS_MEMID_BYTES; i++)
+        if (memid[i].fd >= 0)
+            gpio_byte_read(&memid[i]);
+    // also when watched, not every driver notifies
+    xreg_read();
+}
+
+/* request the lines of one byte from chip, the request fd or -1 */
+static int gpio_request(const char *chip, const uint32_t *offsets, int n, uint64_t flags)
+{
+    struct gpio_v2_line_request req;
+    char path[64];
+    int fd, i;
+
+    if (strchr(chip, '/'))
+        snprintf(path, sizeof(path), "%s", chip);
+    else
+        snprintf(path, sizeof(path), "/dev/%s", chip);
+    fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        printf("gpio_regs: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    memset(&req, 0, sizeof(req));
+    for (i = 0; i < n; i++)
+        req.offsets[i] = offsets[i];
+    snprintf(req.consumer, sizeof(req.consumer), GPIO_REGS_CONSUMER);
+    req.config.flags = flags;
+    req.num_lines = n;
+    if (ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+        dbPrintf("gpio_regs: %s: line request failed: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return req.fd;
+}
+
+/* one line of GPIO_REGS_CONF, 0 for a blank line or comment, -1 when bad */
+static int gpio_conf_line(char *line)
+{
+    char *tok, *save, *end;
+    const char *chip;
+    struct gpio_byte *b;
+    uint32_t offsets[8];
+    uint32_t index;
+    int bank, bit, n = 0;
+    uint64_t flags;
+
+    tok = strtok_r(line, " \t\r\n", &save);
+    if (!tok || *tok == '#')
+        return 0;
+    if (strcmp(tok, "gpi") == 0)
+        bank = GPIO_REGS_GPI;
+    else if (strcmp(tok, "gpo") == 0)
+        bank = GPIO_REGS_GPO;
+    else if (strcmp(tok, "memid") == 0)
+        bank = GPIO_REGS_MEMID;
+    else
+        return -1;
+
+    tok = strtok_r(NULL, " \t\r\n", &save);
+    if (!tok)
+        return -1;
+    index = strtoul(tok, &end, 0);
+    b = gpio_byte_find(bank, index);
+    if (*end || !b || b->fd >= 0)
+        return -1;
+    chip = strtok_r(NULL, " \t\r\n", &save);
+    if (!chip)
+        return -1;
+
+    for (bit = 0; bit < 8 && (tok = strtok_r(NULL, " \t\r\n", &save)); bit++) {
+        if (strcmp(tok, "-") == 0)
+            continue;
+        offsets[n] = strtoul(tok, &end, 0);
+        if (*end)
+            return -1;
+        b->offset[n] = offsets[n];
+        b->bit[n++] = bit;
+    }
+    if (!n)
+        return -1;
+    b->nlines = n;
+
+    switch (bank) {
+    case GPIO_REGS_GPI:
+        flags = GPIO_V2_LINE_FLAG_INPUT;
+        b->fd = gpio_request(chip, offsets, n, flags | GPIO_V2_LINE_FLAG_EDGE_RISING |
+                                               GPIO_V2_LINE_FLAG_EDGE_FALLING);
+        if (b->fd >= 0 && reactor_add_fd(b->fd, EPOLLIN, gpi_event,
+                                         (void *)(uintptr_t)index) == 0) {
+            b->edges = true;
+            break;
+        }
+        // no edge detection on this chip, polled instead
+        if (b->fd >= 0)
+            close(b->fd);
+        b->fd = gpio_request(chip, offsets, n, flags);
+        break;
+    case GPIO_REGS_GPO:
+        // as-is, the board decides the direction and initial level
+        b->fd = gpio_request(chip, offsets, n, 0);
+        break;
+    default:
+        b->fd = gpio_request(chip, offsets, n, GPIO_V2_LINE_FLAG_INPUT);
+        break;
+    }
+    if (b->fd < 0)
+        return -1;
+    gpio_byte_read(b);
+    return 0;
+}
+
+/* gpio_regs_init()
+ *
+ * Lines are requested once and kept: the handlers of 0x0088 only copy the
+ * snapshot, which the edge events, the server ID notification and the
+ * refresh timer keep current.
+ */
+int gpio_regs_init(void)
+{
+    FILE *fp;
+    char line[256];
+    int lineno = 0, bytes = 0;
+
+    gpio_bytes_init();
+
+    if (xreg_read() == 0 &&
+        reactor_add_fd(xreg.fd, EPOLLPRI | EPOLLERR, xreg_event, NULL) == 0)
+        xreg.watched = true;
+
+    fp = fopen(CHIF_PATH(GPIO_REGS_CONF), "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            char *p = line + strspn(line, " \t");
+
+            lineno++;
+            if (*p == '\0' || *p == '\n' || *p == '#')
+                continue;
+            if (gpio_conf_line(line) < 0)
+                printf("gpio_regs: %s:%d ignored\n", CHIF_PATH(GPIO_REGS_CONF), lineno);
+            else
+                bytes++;
+        }
+        fclose(fp);
+    } else {
+        dbPrintf("gpio_regs: no %s, GPIO bytes unmapped\n", CHIF_PATH(GPIO_REGS_CONF));
+    }
+    dbPrintf("gpio_regs: %d GPIO bytes, server ID %s\n", bytes,
+             xreg.watched ? "notified" : "polled");
+
+    refresh_timer = reactor_add_timer(GPIO_REGS_REFRESH_MS, GPIO_REGS_REFRESH_MS,
+                                      gpio_refresh, NULL);
+    return refresh_timer < 0 ? -1 : 0;
+}
+
+static void gpio_bytes_close(struct gpio_byte *b, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        if (b[i].fd < 0)
+            continue;
+        if (b[i].edges)
+            reactor_del_fd(b[i].fd);
+        close(b[i].fd);
+        memset(&b[i], 0, sizeof(b[i]));
+        b[i].fd = -1;
+    }
+}
+
+void gpio_regs_close(void)
+{
+    if (!bytes_init)
+        return;
+    gpio_bytes_close(gpi, GPIO_REGS_GPI_BYTES);
+    gpio_bytes_close(gpo, GPIO_REGS_GPO_BYTES);
+    gpio_bytes_close(memid, GPIO_REGS_MEMID_BYTES);
+    if (xreg.fd >= 0) {
+        if (xreg.watched)
+            reactor_del_fd(xreg.fd);
+        close(xreg.fd);
+    }
+    xreg.fd = -1;
+    xreg.watched = xreg.valid = false;
+}
+
+int gpio_byte_get(int bank, uint32_t index, uint8_t *val)
+{
+    struct gpio_byte *b;
+
+    gpio_bytes_init();
+    b = gpio_byte_find(bank, index);
+    if (!b || b->fd < 0)
+        return -ENOENT;
+    // a snapshot lost to a failed read is retried right away
+    if (!b->valid && gpio_byte_read(b) < 0)
+        return -EIO;
+    *val = b->val;
+    return 0;
+}
+
+int gpio_byte_put(int bank, uint32_t index, uint8_t val)
+{
+    struct gpio_v2_line_values lv;
+    struct gpio_byte *b;
+    int i;
+
+    gpio_bytes_init();
+    b = gpio_byte_find(bank, index);
+    if (bank != GPIO_REGS_GPO || !b || b->fd < 0)
+        return -ENOENT;
+
+    memset(&lv, 0, sizeof(lv));
+    lv.mask = (1ull << b->nlines) - 1;
+    for (i = 0; i < b->nlines; i++)
+        if (val & (1 << b->bit[i]))
+            lv.bits |= 1ull << i;
+    // EPERM when the board left one of the lines an input
+    if (ioctl(b->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv) < 0) {
+        printf("gpio_regs: GPO %u: set values: %s\n", index, strerror(errno));
+        return -EIO;
+    }
+    CHIF_TRACE("gpio gpo %u 0x%02x", index, val);
+    return gpio_byte_read(b);
+}
+
+int gpio_gpi_int_get(bool status, uint32_t index, uint8_t *val)
+{
+    gpio_bytes_init();
+    if (index >= GPIO_REGS_GPI_BYTES || gpi[index].fd < 0)
+        return -ENOENT;
+    *val = status ? gpi[index].st : gpi[index].en;
+    return 0;
+}
+
+int gpio_gpi_int_put(bool status, uint32_t index, uint8_t val)
+{
+    struct gpio_byte *b;
+
+    gpio_bytes_init();
+    if (index >= GPIO_REGS_GPI_BYTES || gpi[index].fd < 0)
+        return -ENOENT;
+    b = &gpi[index];
+    if (status) {
+        b->st &= ~val;
+    } else {
+        // start from the current level, not from whatever was polled last
+        if (!b->edges && (val & ~b->en))
+            gpio_byte_read(b);
+        b->en = val;
+        b->st &= val;
+    }
+    return 0;
+}
+
+/* gpio_xreg_get()
+ *
+ * The server ID is two bytes of the CPLD, index 1 is the low byte.
+ * Served from the snapshot once init has started refreshing it, read
+ * directly otherwise.
+ */
+int gpio_xreg_get(uint8_t index, uint8_t *regValue)
+{
+    if (index != 1 && index != 2)
+        return -ENOENT;
+    if ((refresh_timer < 0 || !xreg.valid) && xreg_read() < 0)
+        return -EIO;
+
+    *regValue = index == 1 ? xreg.val & 0xff : (xreg.val >> 8) & 0xff;
+    return 0;
+}
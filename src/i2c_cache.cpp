@@ -0,0 +1,238 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "chif.hpp"
+#include "i2c_cache.hpp"
+#include "i2c_return_codes.hpp"
+#include "i2c_mapping.hpp"
+#include "smbios.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "misc.hpp"
+
+// DDR4 SPD (EE1004) page select, a write to either switches the page of
+// every SPD on the bus
+#define EE1004_SPA0     0x36
+#define EE1004_SPA1     0x37
+
+struct i2c_cache_entry {
+    uint64_t expires_ns;
+    uint16_t bus;
+    uint8_t addr;
+    uint8_t len;
+    uint8_t data[32];
+};
+
+static std::atomic<uint64_t> cache_ttl_ns{0};
+static std::mutex cache_lock;
+static std::unordered_map<uint64_t, struct i2c_cache_entry> cache;
+static uint8_t policy[I2C_SEGMENTS][128];
+static uint64_t cache_hits, cache_misses, cache_invalidations;
+
+/* key of a read, 0 when the transaction is not a read that can be cached */
+static uint64_t cache_key(int bus, uint8_t addr, const uint8_t *wbuf, uint8_t wlen, uint8_t rlen)
+{
+    uint64_t key;
+    int i;
+
+    if (!rlen || rlen > sizeof(((struct i2c_cache_entry *)0)->data) || wlen > I2C_CACHE_PREFIX ||
+        bus < 0 || bus > 0x3ff)
+        return 0;
+
+    // bus:10 addr:7 wlen:3 rlen:6 prefix:32, never 0 since rlen is not
+    key = (uint64_t)bus << 48 | (uint64_t)(addr & 0x7f) << 41 | (uint64_t)wlen << 38 |
+          (uint64_t)(rlen & 0x3f) << 32;
+    for (i = 0; i < wlen; i++)
+        key |= (uint64_t)wbuf[i] << (8 * i);
+    return key;
+}
+
+/* whether policy lets this read be cached, cache_lock held */
+static bool cache_allowed(uint8_t segment, uint8_t addr, const uint8_t *wbuf, uint8_t wlen)
+{
+    switch (policy[segment][addr & 0x7f]) {
+    case I2C_CACHE_EEPROM:
+        return true;
+    case I2C_CACHE_SPD5:
+        // MemReg bit 7 selects the NVM, the rest are live hub registers
+        return wlen >= 1 && (wbuf[0] & 0x80);
+    default:
+        return false;
+    }
+}
+
+/* drop the entries of one device, or of the whole bus with addr 0xff, cache_lock held */
+static void cache_invalidate(int bus, uint8_t addr)
+{
+    auto it = cache.begin();
+
+    while (it != cache.end()) {
+        if (it->second.bus == bus && (addr == 0xff || it->second.addr == addr)) {
+            it = cache.erase(it);
+            cache_invalidations++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void i2c_cache_enable(unsigned int ttl_ms)
+{
+    cache_ttl_ns.store((uint64_t)ttl_ms * 1000000ull, std::memory_order_relaxed);
+    if (!ttl_ms)
+        i2c_cache_clear();
+}
+
+void i2c_cache_allow(uint8_t segment, uint8_t addr, int kind)
+{
+    std::lock_guard<std::mutex> lock(cache_lock);
+
+    policy[segment][addr & 0x7f] = kind;
+}
+
+/* i2c_cache_policy_smbios()
+ *
+ * The SPD of a DIMM sits at 0xA0 plus the A2..A0 strap of the thermal sensor
+ * that type 227 names.  DDR5 modules have an SPD hub whose registers change
+ * under us, only its NVM is cached.  Entries cached under the old policy
+ * are dropped, the DIMMs may have moved.
+ */
+void i2c_cache_policy_smbios(void)
+{
+    std::lock_guard<std::mutex> lock(cache_lock);
+    type_dimm d;
+    int i, n = 0;
+
+    memset(policy, 0, sizeof(policy));
+    cache.clear();
+
+    for (i = 0; !smbios_get_dimm(i, &d); i++) {
+        if (!d.dimm.status || d.i2c.mstr != SMBIOS_T228_TYPE_I2C)
+            continue;
+        policy[d.i2c.seg][(0xA0 | (d.i2c.addr & 0x0E)) >> 1] =
+            d.i2c.spd_size == 1024 ? I2C_CACHE_SPD5 : I2C_CACHE_EEPROM;
+        n++;
+    }
+    dbPrintf("i2c_cache: %d SPD EEPROMs cacheable\n", n);
+}
+
+bool i2c_cache_get(uint8_t segment, int bus, uint8_t addr, const uint8_t *wbuf,
+                   uint8_t wlen, uint8_t *rbuf, uint8_t rlen)
+{
+    uint64_t key, now;
+
+    if (!cache_ttl_ns.load(std::memory_order_relaxed))
+        return false;
+    key = cache_key(bus, addr, wbuf, wlen, rlen);
+    if (!key)
+        return false;
+
+    std::lock_guard<std::mutex> lock(cache_lock);
+
+    if (!cache_allowed(segment, addr, wbuf, wlen))
+        return false;
+
+    auto it = cache.find(key);
+    now = stats_now_ns();
+    if (it == cache.end() || it->second.expires_ns <= now) {
+        if (it != cache.end())
+            cache.erase(it);
+        cache_misses++;
+        return false;
+    }
+
+    memcpy(rbuf, it->second.data, rlen);
+    cache_hits++;
+    CHIF_TRACE("i2c cache hit bus %d addr 0x%02x r%u", bus, addr, rlen);
+    return true;
+}
+
+void i2c_cache_update(uint8_t segment, int bus, uint8_t addr, const uint8_t *wbuf,
+                      uint8_t wlen, const uint8_t *rbuf, uint8_t rlen, int rc)
+{
+    uint64_t ttl = cache_ttl_ns.load(std::memory_order_relaxed);
+    uint64_t key, now;
+
+    if (!ttl)
+        return;
+    key = cache_key(bus, addr, wbuf, wlen, rlen);
+
+    std::lock_guard<std::mutex> lock(cache_lock);
+
+    if (!key) {
+        // a write, or something too long to be one of our reads
+        if (cache.empty())
+            return;
+        if (addr == EE1004_SPA0 || addr == EE1004_SPA1)
+            cache_invalidate(bus, 0xff);
+        else
+            cache_invalidate(bus, addr);
+        return;
+    }
+    if (rc != I2C_SUCCESS || !cache_allowed(segment, addr, wbuf, wlen))
+        return;
+
+    now = stats_now_ns();
+    if (cache.size() >= I2C_CACHE_ENTRIES) {
+        auto it = cache.begin();
+
+        while (it != cache.end()) {
+            if (it->second.expires_ns <= now)
+                it = cache.erase(it);
+            else
+                ++it;
+        }
+        if (cache.size() >= I2C_CACHE_ENTRIES)
+            cache.clear();
+    }
+
+    struct i2c_cache_entry &e = cache[key];
+    e.expires_ns = now + ttl;
+    e.bus = bus;
+    e.addr = addr;
+    e.len = rlen;
+    memcpy(e.data, rbuf, rlen);
+}
+
+void i2c_cache_clear(void)
+{
+    std::lock_guard<std::mutex> lock(cache_lock);
+
+    cache.clear();
+}
+
+void i2c_cache_stats(FILE *fp, bool reset)
+{
+    std::lock_guard<std::mutex> lock(cache_lock);
+
+    if (!cache_ttl_ns.load(std::memory_order_relaxed))
+        return;
+    fprintf(fp, "I2C read cache: %zu entries, hits=%llu misses=%llu invalidated=%llu\n",
+            cache.size(), (unsigned long long)cache_hits, (unsigned long long)cache_misses,
+            (unsigned long long)cache_invalidations);
+    if (reset)
+        cache_hits = cache_misses = cache_invalidations = 0;
+    fflush(fp);
+}
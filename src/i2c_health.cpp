@@ -0,0 +1,175 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <mutex>
+#include <unordered_map>
+
+#include "i2c_health.hpp"
+#include "i2c_return_codes.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "misc.hpp"
+
+struct i2c_health {
+    uint8_t segment;
+    bool probing;           // the half-open probe is on the bus
+    int last_rc;
+    uint32_t fails;         // consecutive
+    uint32_t backoff_ms;    // 0 while the circuit is closed
+    uint64_t open_until_ns;
+    uint64_t ok, failed, fast_failed, trips;
+};
+
+static std::mutex health_lock;
+static std::unordered_map<uint32_t, struct i2c_health> health;
+
+static uint32_t health_key(int bus, uint8_t addr)
+{
+    return (uint32_t)bus << 7 | (addr & 0x7f);
+}
+
+/* whether rc says something about the device rather than the request or the segment */
+static bool device_fault(int rc)
+{
+    switch (rc) {
+    case I2C_ADDRESS_NACK:
+    case I2C_DATA_NACK:
+    case I2C_BUS_TIMEOUT:
+    case I2C_TRANSACTION_TIMEOUT:
+    case I2C_GENERAL_ERROR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int i2c_health_check(int bus, uint8_t addr, bool *retry)
+{
+    std::lock_guard<std::mutex> lock(health_lock);
+    struct i2c_health *h;
+
+    *retry = true;
+    if (health.empty())
+        return I2C_SUCCESS;
+    auto it = health.find(health_key(bus, addr));
+    if (it == health.end())
+        return I2C_SUCCESS;
+    h = &it->second;
+
+    if (h->fails)
+        *retry = false;
+    if (!h->backoff_ms)
+        return I2C_SUCCESS;
+
+    if (h->probing || stats_now_ns() < h->open_until_ns) {
+        h->fast_failed++;
+        return h->last_rc;
+    }
+
+    // half-open: this request is the probe
+    h->probing = true;
+    CHIF_TRACE("i2c health probe bus %d addr 0x%02x", bus, addr);
+    return I2C_SUCCESS;
+}
+
+void i2c_health_record(uint8_t segment, int bus, uint8_t addr, int rc)
+{
+    std::lock_guard<std::mutex> lock(health_lock);
+    struct i2c_health *h;
+
+    auto it = health.find(health_key(bus, addr));
+
+    if (rc == I2C_SUCCESS) {
+        if (it == health.end())
+            return;
+        h = &it->second;
+        if (h->backoff_ms)
+            printf("I2C device at segment %02x bus %d addr %02x is back\n", h->segment, bus, addr);
+        h->ok++;
+        h->fails = 0;
+        h->backoff_ms = 0;
+        h->probing = false;
+        return;
+    }
+    if (!device_fault(rc)) {
+        // the probe told us nothing, let the next request try again
+        if (it != health.end())
+            it->second.probing = false;
+        return;
+    }
+
+    if (it == health.end()) {
+        if (health.size() >= I2C_HEALTH_ENTRIES)
+            return;
+        it = health.emplace(health_key(bus, addr), i2c_health()).first;
+    }
+    h = &it->second;
+    h->segment = segment;
+    h->last_rc = rc;
+    h->failed++;
+    h->fails++;
+
+    if (h->backoff_ms) {
+        // failed probe
+        h->backoff_ms = h->backoff_ms * 2 < I2C_HEALTH_BACKOFF_MAX_MS ?
+                        h->backoff_ms * 2 : I2C_HEALTH_BACKOFF_MAX_MS;
+    } else if (h->fails >= I2C_HEALTH_TRIP) {
+        h->backoff_ms = I2C_HEALTH_BACKOFF_MS;
+        h->trips++;
+        printf("I2C device at segment %02x bus %d addr %02x failed %u times (error %d), backing off\n",
+               segment, bus, addr, h->fails, rc);
+    } else {
+        return;
+    }
+    h->probing = false;
+    h->open_until_ns = stats_now_ns() + (uint64_t)h->backoff_ms * 1000000ull;
+    CHIF_TRACE("i2c health open bus %d addr 0x%02x %u ms", bus, addr, h->backoff_ms);
+}
+
+void i2c_health_dump(FILE *fp)
+{
+    std::lock_guard<std::mutex> lock(health_lock);
+    uint64_t now = stats_now_ns();
+
+    if (health.empty())
+        return;
+    fprintf(fp, "I2C device health, devices that failed since start\n");
+    for (auto &it : health) {
+        const struct i2c_health *h = &it.second;
+        const char *state = !h->backoff_ms ? "closed" : h->probing ? "probing" :
+                            now < h->open_until_ns ? "open" : "half-open";
+
+        fprintf(fp, "  seg %02x bus %3u addr %02x %-9s fails=%u backoff=%ums last_error=%d"
+                " ok=%llu failed=%llu fast_failed=%llu trips=%llu\n",
+                h->segment, it.first >> 7, it.first & 0x7f, state, h->fails, h->backoff_ms,
+                h->last_rc, (unsigned long long)h->ok, (unsigned long long)h->failed,
+                (unsigned long long)h->fast_failed, (unsigned long long)h->trips);
+    }
+    fflush(fp);
+}
+
+/* counters only, open circuits stay open */
+void i2c_health_reset(void)
+{
+    std::lock_guard<std::mutex> lock(health_lock);
+
+    for (auto &it : health)
+        it.second.ok = it.second.failed = it.second.fast_failed = it.second.trips = 0;
+}
@@ -19,33 +19,200 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <atomic>
+#include <memory>
+#include <string>
 #include "chif.hpp"
 #include "i2c_mapping.hpp"
+#include "platdef_api.hpp"
+#include "i2c_topology.hpp"
+#include "reactor.hpp"
 #include "misc.hpp"
 
-struct i2cMapEntry i2cSystemEntries[MAX_I2C_TABLE_REMAP];
-int i2cAllocatedEntries=0;
+#define I2C_MAPPING_RETRY_MS    5000    // look for the map directory again
+
+static std::shared_ptr<const struct i2c_map> empty_map(void)
+{
+    std::shared_ptr<struct i2c_map> map = std::make_shared<struct i2c_map>();
+    int seg;
+
+    map->entries = 0;
+    for (seg = 0; seg < I2C_SEGMENTS; seg++)
+        map->segment_bus[seg] = -1;
+    return map;
+}
+
+static std::atomic<std::shared_ptr<const struct i2c_map>> cur_map{empty_map()};
+static bool i2cMappingLoaded = false;
+
+std::shared_ptr<const struct i2c_map> i2c_map_get(void)
+{
+    return cur_map.load(std::memory_order_acquire);
+}
+
+/* map_segments()
+ *
+ * A segment maps to the kernel bus of the first mapping line whose CPLD
+ * register and value match the mux control of the segment.  Segments of
+ * the topology without a match are reported here, once per rebuild.
+ */
+static void map_segments(struct i2c_map *map)
+{
+    char missing[I2C_SEGMENTS * 4 + 1];
+    size_t len = 0;
+    int seg, i;
+
+    for (seg = 0; seg < I2C_SEGMENTS; seg++) {
+        map->segment_bus[seg] = -1;
+        for (i = 0; i < map->entries; i++) {
+            if ((apml_segments[seg].MuxControl.CPLD.Byte == map->entry[i].cpldReg) &&
+                (apml_segments[seg].MuxControl.CPLD.SelectMask == map->entry[i].RegVal)) {
+                map->segment_bus[seg] = map->entry[i].i2cKernelSegment;
+                break;
+            }
+        }
+
+        // no point in listing every segment before the mapping file is read
+        if (map->segment_bus[seg] < 0 && i2cMappingLoaded && segment_to_engine[seg] != 0xFF)
+            len += snprintf(&missing[len], sizeof(missing) - len, " %d", seg);
+    }
+
+    if (len)
+        printf("I2CMAP: no kernel bus for segments%s\n", missing);
+}
+
+void build_i2c_segment_map(void)
+{
+    std::shared_ptr<struct i2c_map> map = std::make_shared<struct i2c_map>(*i2c_map_get());
+
+    map_segments(map.get());
+    cur_map.store(map, std::memory_order_release);
+}
 
 void load_i2c_mapping()
 {
+    std::shared_ptr<struct i2c_map> map = std::make_shared<struct i2c_map>();
     FILE *mapping;
     char input[1024];
+    struct i2cMapEntry *e;
+
     dbPrintf("loading i2c mapping file\n");
-    mapping=fopen(I2C_MAPPING,"r");
-    if ( mapping != NULL )
+    mapping=fopen(CHIF_PATH(I2C_MAPPING),"r");
+    if ( mapping == NULL )
     {
-        while(fgets(input, 1024, mapping) != NULL )
+        // keep what was loaded before, the file may be about to be replaced
+        printf("I2CMAP: i2c mapping file do not exist\n");
+        return;
+    }
+
+    map->entries = 0;
+    while(fgets(input, 1024, mapping) != NULL )
+    {
+        if ( map->entries < MAX_I2C_TABLE_REMAP )
         {
-            if ( i2cAllocatedEntries < MAX_I2C_TABLE_REMAP )
-            {
-                sscanf(input,"%hx %hu %hu\n", &i2cSystemEntries[i2cAllocatedEntries].cpldReg,
-                               &i2cSystemEntries[i2cAllocatedEntries].RegVal,
-                               &i2cSystemEntries[i2cAllocatedEntries].i2cKernelSegment);
-                i2cAllocatedEntries++;
-            }
+            e = &map->entry[map->entries];
+            if (sscanf(input,"%hx %hu %hu\n", &e->cpldReg, &e->RegVal, &e->i2cKernelSegment) == 3)
+                map->entries++;
         }
-        fclose(mapping);
     }
-    else
-        printf("I2CMAP: i2c mapping file do not exist\n");
+    fclose(mapping);
+
+    i2cMappingLoaded = true;
+    map_segments(map.get());
+    cur_map.store(map, std::memory_order_release);
+    dbPrintf("I2CMAP: %d mapping entries\n", map->entries);
+}
+
+/*
+ * inotify on the directory of the map, so that a file created later or
+ * replaced by rename() is seen as well
+ */
+static struct {
+    int fd;
+    int wd;
+    int timer;
+    std::string dir;
+    std::string name;
+} watch = { -1, -1, -1, "", "" };
+
+static int watch_add(void)
+{
+    watch.wd = inotify_add_watch(watch.fd, watch.dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch.wd < 0) {
+        dbPrintf("I2CMAP: cannot watch %s: %s\n", watch.dir.c_str(), strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/* the directory did not exist, or went away */
+static void watch_retry(int timer, void *ctx)
+{
+    (void)ctx;
+
+    if (watch_add() < 0)
+        return;
+    reactor_arm_timer(timer, 0, 0);
+    // the file may have been written while nobody was watching
+    if (access(CHIF_PATH(I2C_MAPPING), R_OK) == 0)
+        load_i2c_mapping();
+}
+
+static void watch_event(int fd, uint32_t events, void *ctx)
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *ev;
+    bool reload = false, lost = false;
+    ssize_t n;
+    char *p;
+
+    (void)events;
+    (void)ctx;
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (p = buf; p < buf + n; p += sizeof(*ev) + ev->len) {
+            ev = (const struct inotify_event *)p;
+            if (ev->mask & IN_IGNORED)
+                lost = true;
+            else if (ev->len && watch.name == ev->name)
+                reload = true;
+        }
+    }
+
+    if (reload) {
+        printf("I2CMAP: %s changed, reloading\n", CHIF_PATH(I2C_MAPPING));
+        load_i2c_mapping();
+    }
+    if (lost) {
+        watch.wd = -1;
+        reactor_arm_timer(watch.timer, I2C_MAPPING_RETRY_MS, I2C_MAPPING_RETRY_MS);
+    }
+}
+
+int i2c_mapping_watch(void)
+{
+    std::string path = CHIF_PATH(I2C_MAPPING);
+    size_t slash = path.rfind('/');
+
+    watch.dir = path.substr(0, slash);
+    watch.name = path.substr(slash + 1);
+
+    watch.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch.fd < 0) {
+        printf("I2CMAP: inotify_init1 failed: %s\n", strerror(errno));
+        return -1;
+    }
+    if (reactor_add_fd(watch.fd, EPOLLIN, watch_event, NULL) < 0)
+        return -1;
+    watch.timer = reactor_add_timer(0, 0, watch_retry, NULL);
+    if (watch.timer < 0)
+        return -1;
+
+    if (watch_add() < 0)
+        reactor_arm_timer(watch.timer, I2C_MAPPING_RETRY_MS, I2C_MAPPING_RETRY_MS);
+    return 0;
 }
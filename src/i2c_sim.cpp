@@ -0,0 +1,233 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "i2c_sim.hpp"
+#include "i2c_return_codes.hpp"
+#include "trace.hpp"
+#include "misc.hpp"
+
+#define I2C_SIM_MAX_SIZE    65536
+
+struct i2c_sim_dev {
+    std::vector<uint8_t> mem;
+    bool addr16;
+    uint32_t ptr;
+    uint32_t latency_us;
+    uint32_t byte_us;
+    uint32_t nak_pct;
+    uint32_t timeout_pct;
+    uint32_t timeout_us;
+    uint32_t seed;
+};
+
+struct i2c_sim_bus {
+    std::mutex lock;        // held for the length of a transaction, like the wire
+    std::unique_ptr<struct i2c_sim_dev> dev[128];
+};
+
+/* buses are added before the transactions start and only go away in i2c_sim_clear() */
+static std::mutex sim_lock;
+static std::unique_ptr<struct i2c_sim_bus> sim_bus[I2C_XFER_MAX_BUS];
+
+static uint32_t sim_rand(struct i2c_sim_dev *d)
+{
+    d->seed ^= d->seed << 13;
+    d->seed ^= d->seed >> 17;
+    d->seed ^= d->seed << 5;
+    return d->seed;
+}
+
+static void sim_delay(uint32_t us)
+{
+    if (us)
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static int sim_xfer(int bus, uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+                    uint8_t *rbuf, uint8_t rlen)
+{
+    struct i2c_sim_bus *b;
+    struct i2c_sim_dev *d;
+    uint32_t roll, size, i;
+
+    {
+        std::lock_guard<std::mutex> lock(sim_lock);
+        b = sim_bus[bus].get();
+    }
+    if (!b)
+        return I2C_SEGMENT_DOES_NOT_EXIST;
+
+    std::lock_guard<std::mutex> lock(b->lock);
+    CHIF_TRACE("i2c sim bus %d addr 0x%02x w%u r%u", bus, addr, wlen, rlen);
+    d = b->dev[addr].get();
+    if (!d)
+        return I2C_ADDRESS_NACK;
+
+    roll = sim_rand(d) % 100;
+    if (roll < d->timeout_pct) {
+        sim_delay(d->timeout_us);
+        return I2C_BUS_TIMEOUT;
+    }
+    if (roll < d->timeout_pct + d->nak_pct) {
+        sim_delay(d->latency_us + d->byte_us);
+        return I2C_ADDRESS_NACK;
+    }
+
+    // address byte, the write, then the address again and the read
+    sim_delay(d->latency_us + d->byte_us * (1 + wlen + (rlen ? 1 + rlen : 0)));
+
+    size = d->mem.size();
+    if (wlen >= (d->addr16 ? 2 : 1)) {
+        d->ptr = (d->addr16 ? (uint32_t)wbuf[0] << 8 | wbuf[1] : wbuf[0]) % size;
+        for (i = d->addr16 ? 2 : 1; i < wlen; i++) {
+            d->mem[d->ptr] = wbuf[i];
+            d->ptr = (d->ptr + 1) % size;
+        }
+    }
+    for (i = 0; i < rlen; i++) {
+        rbuf[i] = d->mem[d->ptr];
+        d->ptr = (d->ptr + 1) % size;
+    }
+    return I2C_SUCCESS;
+}
+
+static void sim_close(void)
+{
+    i2c_sim_clear();
+}
+
+const struct i2c_backend i2c_sim_backend = { "sim", sim_xfer, sim_close };
+
+int i2c_sim_add(const char *line)
+{
+    std::unique_ptr<struct i2c_sim_dev> d(new i2c_sim_dev());
+    std::string s(line);
+    const char *file = NULL;
+    char *tok, *save, *end;
+    int bus, addr, fill = -1;
+    uint32_t size = 256, i;
+
+    tok = strtok_r(&s[0], " \t\r\n", &save);
+    if (!tok || *tok == '#')
+        return 0;
+    bus = strtol(tok, &end, 0);
+    if (*end || bus < 0 || bus >= I2C_XFER_MAX_BUS)
+        goto bad;
+    tok = strtok_r(NULL, " \t\r\n", &save);
+    if (!tok)
+        goto bad;
+    addr = strtol(tok, &end, 0);
+    if (*end || addr < 0 || addr > 0x7f)
+        goto bad;
+
+    d->timeout_us = 25000;
+    while ((tok = strtok_r(NULL, " \t\r\n", &save)) && *tok != '#') {
+        if (strncmp(tok, "size=", 5) == 0)
+            size = strtoul(tok + 5, NULL, 0);
+        else if (strcmp(tok, "addr16") == 0)
+            d->addr16 = true;
+        else if (strncmp(tok, "fill=", 5) == 0)
+            fill = strtoul(tok + 5, NULL, 0) & 0xff;
+        else if (strncmp(tok, "file=", 5) == 0)
+            file = tok + 5;
+        else if (strncmp(tok, "latency=", 8) == 0)
+            d->latency_us = strtoul(tok + 8, NULL, 0);
+        else if (strncmp(tok, "byte=", 5) == 0)
+            d->byte_us = strtoul(tok + 5, NULL, 0);
+        else if (strncmp(tok, "nak=", 4) == 0)
+            d->nak_pct = strtoul(tok + 4, NULL, 0);
+        else if (strncmp(tok, "timeout=", 8) == 0)
+            d->timeout_pct = strtoul(tok + 8, NULL, 0);
+        else if (strncmp(tok, "timeout_us=", 11) == 0)
+            d->timeout_us = strtoul(tok + 11, NULL, 0);
+        else
+            goto bad;
+    }
+    if (!size || size > I2C_SIM_MAX_SIZE || d->nak_pct + d->timeout_pct > 100)
+        goto bad;
+
+    d->mem.resize(size);
+    for (i = 0; i < size; i++)
+        d->mem[i] = fill >= 0 ? fill : (uint8_t)(i ^ addr);
+    if (file) {
+        FILE *fp = fopen(file, "rb");
+
+        if (!fp) {
+            printf("i2c_sim: cannot open %s\n", file);
+            return -1;
+        }
+        if (fread(d->mem.data(), 1, size, fp) == 0)
+            printf("i2c_sim: %s is empty\n", file);
+        fclose(fp);
+    }
+    d->seed = (uint32_t)bus << 8 | addr | 0x10000;
+
+    {
+        std::lock_guard<std::mutex> lock(sim_lock);
+
+        if (!sim_bus[bus])
+            sim_bus[bus].reset(new i2c_sim_bus());
+        std::lock_guard<std::mutex> bus_lock(sim_bus[bus]->lock);
+        sim_bus[bus]->dev[addr] = std::move(d);
+    }
+    dbPrintf("i2c_sim: bus %d addr 0x%02x %u bytes\n", bus, addr, size);
+    return 0;
+
+bad:
+    printf("i2c_sim: bad device line: %s\n", line);
+    return -1;
+}
+
+int i2c_sim_load(const char *path)
+{
+    char line[512];
+    FILE *fp;
+    int rc = 0;
+
+    fp = fopen(path, "r");
+    if (!fp) {
+        printf("i2c_sim: cannot open %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        if (i2c_sim_add(line) < 0)
+            rc = -1;
+    }
+    fclose(fp);
+    return rc;
+}
+
+void i2c_sim_clear(void)
+{
+    std::lock_guard<std::mutex> lock(sim_lock);
+    int i;
+
+    for (i = 0; i < I2C_XFER_MAX_BUS; i++)
+        sim_bus[i].reset();
+}
@@ -0,0 +1,187 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+
+#include "i2c_stats.hpp"
+#include "i2c_return_codes.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+
+struct i2c_dev_stats {
+    bool used;
+    uint8_t segment;
+    uint8_t addr;
+    int bus;
+    int last_rc;
+    uint64_t count;
+    uint64_t errors;
+    uint64_t nacks;             // I2C_ADDRESS_NACK, nobody home
+    uint64_t retries;
+    struct lat_hist lat;
+};
+
+/* workers on different lanes account at the same time */
+static std::mutex i2c_stats_lock;
+static struct i2c_dev_stats dev_stats[I2C_STATS_SLOTS];
+static struct i2c_dev_stats overflow_stats;
+static struct i2c_dev_stats sum_stats[I2C_STATS_SLOTS];     // dump scratch
+
+static struct i2c_dev_stats *i2c_stats_slot(uint8_t segment, uint8_t addr)
+{
+    uint32_t key = (uint32_t)segment << 8 | addr;
+    uint32_t i, slot;
+
+    for (i = 0; i < I2C_STATS_SLOTS; i++) {
+        slot = (key * 2654435761u + i) & (I2C_STATS_SLOTS - 1);
+        if (!dev_stats[slot].used) {
+            dev_stats[slot].used = true;
+            dev_stats[slot].segment = segment;
+            dev_stats[slot].addr = addr;
+            return &dev_stats[slot];
+        }
+        if (dev_stats[slot].segment == segment && dev_stats[slot].addr == addr)
+            return &dev_stats[slot];
+    }
+    return &overflow_stats;
+}
+
+void i2c_stats_record(uint8_t segment, int bus, uint8_t addr, uint8_t wlen, uint8_t rlen,
+                      int retries, int rc, uint64_t ns)
+{
+    struct i2c_dev_stats *st;
+
+    CHIF_TRACE("i2c seg %02x bus %d addr 0x%02x w%u r%u retries %d rc %d %lluus",
+               segment, bus, addr, wlen, rlen, retries, rc, ns / 1000);
+
+    std::lock_guard<std::mutex> lock(i2c_stats_lock);
+
+    st = i2c_stats_slot(segment, addr);
+    st->bus = bus;
+    st->count++;
+    st->retries += retries;
+    if (rc != I2C_SUCCESS) {
+        st->errors++;
+        st->last_rc = rc;
+        if (rc == I2C_ADDRESS_NACK)
+            st->nacks++;
+    }
+    lat_hist_add(&st->lat, ns);
+}
+
+static void i2c_stats_add(struct i2c_dev_stats *sum, const struct i2c_dev_stats *st)
+{
+    sum->count += st->count;
+    sum->errors += st->errors;
+    sum->nacks += st->nacks;
+    sum->retries += st->retries;
+    if (st->errors)
+        sum->last_rc = st->last_rc;
+    lat_hist_merge(&sum->lat, &st->lat);
+}
+
+static void i2c_stats_print(FILE *fp, const char *label, const struct i2c_dev_stats *st)
+{
+    fprintf(fp, "  %-24s count=%llu errors=%llu nacks=%llu retries=%llu", label,
+            (unsigned long long)st->count, (unsigned long long)st->errors,
+            (unsigned long long)st->nacks, (unsigned long long)st->retries);
+    if (st->errors)
+        fprintf(fp, " last_error=%d", st->last_rc);
+    fprintf(fp, "\n");
+    lat_hist_print(fp, "latency", &st->lat);
+}
+
+/* i2c_stats_sum()
+ *
+ * Add the device entries up by kernel bus (by_bus) or by segment into
+ * sum_stats, keyed the same way the device table is.
+ */
+static void i2c_stats_sum(bool by_bus)
+{
+    struct i2c_dev_stats *sum;
+    uint32_t i, j, key;
+
+    memset(sum_stats, 0, sizeof(sum_stats));
+    for (i = 0; i < I2C_STATS_SLOTS; i++) {
+        if (!dev_stats[i].used)
+            continue;
+        key = by_bus ? (uint32_t)dev_stats[i].bus : dev_stats[i].segment;
+        for (j = 0; j < I2C_STATS_SLOTS; j++) {
+            sum = &sum_stats[(key * 2654435761u + j) & (I2C_STATS_SLOTS - 1)];
+            if (!sum->used) {
+                sum->used = true;
+                sum->bus = dev_stats[i].bus;
+                sum->segment = dev_stats[i].segment;
+                break;
+            }
+            if (by_bus ? sum->bus == dev_stats[i].bus : sum->segment == dev_stats[i].segment)
+                break;
+        }
+        i2c_stats_add(sum, &dev_stats[i]);
+    }
+}
+
+void i2c_stats_dump(FILE *fp)
+{
+    std::lock_guard<std::mutex> lock(i2c_stats_lock);
+    char label[32];
+    uint32_t i;
+    int pass;
+
+    for (i = 0; i < I2C_STATS_SLOTS && !dev_stats[i].used; i++)
+        ;
+    if (i == I2C_STATS_SLOTS && !overflow_stats.count)
+        return;
+
+    for (pass = 0; pass < 2; pass++) {
+        fprintf(fp, "I2C transactions by %s\n", pass ? "segment" : "bus");
+        i2c_stats_sum(pass == 0);
+        for (i = 0; i < I2C_STATS_SLOTS; i++) {
+            if (!sum_stats[i].used)
+                continue;
+            if (pass)
+                snprintf(label, sizeof(label), "seg %02x (bus %d)", sum_stats[i].segment, sum_stats[i].bus);
+            else
+                snprintf(label, sizeof(label), "bus %d", sum_stats[i].bus);
+            i2c_stats_print(fp, label, &sum_stats[i]);
+        }
+    }
+
+    fprintf(fp, "I2C transactions by device\n");
+    for (i = 0; i < I2C_STATS_SLOTS; i++) {
+        if (!dev_stats[i].used)
+            continue;
+        snprintf(label, sizeof(label), "seg %02x bus %d addr %02x",
+                 dev_stats[i].segment, dev_stats[i].bus, dev_stats[i].addr);
+        i2c_stats_print(fp, label, &dev_stats[i]);
+    }
+    if (overflow_stats.count)
+        i2c_stats_print(fp, "other", &overflow_stats);
+    fflush(fp);
+}
+
+void i2c_stats_reset(void)
+{
+    std::lock_guard<std::mutex> lock(i2c_stats_lock);
+
+    memset(dev_stats, 0, sizeof(dev_stats));
+    memset(&overflow_stats, 0, sizeof(overflow_stats));
+}
@@ -24,10 +24,11 @@
 
 #include "platdef.h"
 #include "platdef_api.hpp"
+#include "i2c_mapping.hpp"
 
 #define I2C_ENGINE_COUNT                    10
 #define I2C_STANDARD_ENGINES                9       //This does not include DDC and SNA engine
-#define I2C_SEGMENT_COUNT                   255
+#define I2C_SEGMENT_COUNT                   256     // segment IDs are one byte
 
 
 /*
@@ -99,4 +100,6 @@ void update_i2c_topology(void)
             memset(&(apml_segments[j]), 0, sizeof(PlatDefI2CSegment));
         }
     }
+
+    build_i2c_segment_map();
 }
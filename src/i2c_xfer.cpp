@@ -0,0 +1,197 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <mutex>
+
+#include "i2c_xfer.hpp"
+#include "i2c_sim.hpp"
+#include "trace.hpp"
+#include "misc.hpp"
+
+static std::mutex bus_lock;
+static int bus_fd[I2C_XFER_MAX_BUS];
+static bool bus_fd_init;
+
+/* cached descriptor of /dev/i2c-<bus>, -errno when it cannot be opened */
+static int bus_open(int bus)
+{
+    std::lock_guard<std::mutex> lock(bus_lock);
+    char path[32];
+    int i, fd;
+
+    if (!bus_fd_init) {
+        for (i = 0; i < I2C_XFER_MAX_BUS; i++)
+            bus_fd[i] = -1;
+        bus_fd_init = true;
+    }
+    if (bus_fd[bus] >= 0)
+        return bus_fd[bus];
+
+    snprintf(path, sizeof(path), "/dev/i2c-%d", bus);
+    fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        dbPrintf("i2c_xfer: cannot open %s: %s\n", path, strerror(errno));
+        return -errno;
+    }
+    bus_fd[bus] = fd;
+    return fd;
+}
+
+/* forget a descriptor whose adapter went away, the next call reopens it */
+static void bus_drop(int bus, int fd)
+{
+    std::lock_guard<std::mutex> lock(bus_lock);
+
+    if (bus_fd[bus] == fd) {
+        close(fd);
+        bus_fd[bus] = -1;
+    }
+}
+
+int i2c_xfer_errno(int err)
+{
+    switch (err) {
+    case 0:
+        return I2C_SUCCESS;
+    case ENXIO:             // no ACK in the address phase
+    case EREMOTEIO:
+        return I2C_ADDRESS_NACK;
+    case ENOENT:
+    case ENODEV:
+        return I2C_SEGMENT_DOES_NOT_EXIST;
+    case EAGAIN:            // arbitration lost
+        return I2C_LOST_ARBITRATION;
+    case EBUSY:             // bus held low
+        return I2C_SEGMENT_HUNG;
+    case ETIMEDOUT:
+        return I2C_BUS_TIMEOUT;
+    case EINVAL:
+        return I2C_BAD_ARGUMENT;
+    case EOPNOTSUPP:
+        return I2C_UNSUPPORTED_TRANSACTION_TYPE;
+    case EACCES:
+    case EPERM:
+        return I2C_CONNECTION_ERROR;
+    case ESHUTDOWN:         // adapter suspended
+        return I2C_ENGINE_DISABLED_ON_AUX_POWER;
+    default:                // EIO, EPROTO, EBADMSG
+        return I2C_GENERAL_ERROR;
+    }
+}
+
+static int dev_xfer(int bus, uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+                    uint8_t *rbuf, uint8_t rlen)
+{
+    struct i2c_msg msgs[2];
+    struct i2c_rdwr_ioctl_data xfer;
+    int fd, n = 0;
+
+    fd = bus_open(bus);
+    if (fd < 0)
+        return i2c_xfer_errno(-fd);
+
+    // a zero length write when there is nothing else, like "w0@ADDR"
+    if (wlen || !rlen) {
+        msgs[n].addr = addr;
+        msgs[n].flags = 0;
+        msgs[n].len = wlen;
+        msgs[n].buf = (uint8_t *)wbuf;
+        n++;
+    }
+    if (rlen) {
+        msgs[n].addr = addr;
+        msgs[n].flags = I2C_M_RD;
+        msgs[n].len = rlen;
+        msgs[n].buf = rbuf;
+        n++;
+    }
+    xfer.msgs = msgs;
+    xfer.nmsgs = n;
+
+    CHIF_TRACE("i2c bus %d addr 0x%02x w%u r%u", bus, addr, wlen, rlen);
+    if (ioctl(fd, I2C_RDWR, &xfer) < 0) {
+        int err = errno;
+
+        dbPrintf("i2c_xfer: bus %d addr 0x%02x: %s\n", bus, addr, strerror(err));
+        CHIF_TRACE("i2c bus %d addr 0x%02x errno %d", bus, addr, err);
+        if (err == ENODEV || err == EBADF)
+            bus_drop(bus, fd);
+        return i2c_xfer_errno(err);
+    }
+    return I2C_SUCCESS;
+}
+
+static void dev_close(void)
+{
+    std::lock_guard<std::mutex> lock(bus_lock);
+    int i;
+
+    if (!bus_fd_init)
+        return;
+    for (i = 0; i < I2C_XFER_MAX_BUS; i++) {
+        if (bus_fd[i] >= 0)
+            close(bus_fd[i]);
+        bus_fd[i] = -1;
+    }
+}
+
+static const struct i2c_backend dev_backend = { "dev", dev_xfer, dev_close };
+static const struct i2c_backend *backend = &dev_backend;
+
+int i2c_backend_open(const char *spec)
+{
+    if (strcmp(spec, "dev") == 0) {
+        backend = &dev_backend;
+    } else if (strcmp(spec, "sim") == 0) {
+        backend = &i2c_sim_backend;
+    } else if (strncmp(spec, "sim:", 4) == 0) {
+        if (i2c_sim_load(spec + 4) < 0)
+            return -1;
+        backend = &i2c_sim_backend;
+    } else {
+        printf("i2c_xfer: unknown backend %s\n", spec);
+        return -1;
+    }
+    printf("I2C backend %s\n", spec);
+    return 0;
+}
+
+int i2c_xfer(int bus, uint8_t addr, const uint8_t *wbuf, uint8_t wlen,
+             uint8_t *rbuf, uint8_t rlen)
+{
+    if (bus < 0 || bus >= I2C_XFER_MAX_BUS || addr > 0x7f)
+        return I2C_BAD_ARGUMENT;
+    if (wlen > I2C_XFER_MAX_LEN || rlen > I2C_XFER_MAX_LEN)
+        return I2C_SIZE_GREATER_THAN_MAX_STANDARD_TRANSACT_ERROR;
+
+    return backend->xfer(bus, addr, wbuf, wlen, rbuf, rlen);
+}
+
+void i2c_xfer_close(void)
+{
+    backend->close();
+}
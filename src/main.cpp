@@ -29,6 +29,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <signal.h>
 
 #include "chif.hpp"
 #include "smif.hpp"
@@ -41,6 +42,16 @@
 #include "uefi_util.hpp"
 #include "platdef_api.hpp"
 #include "i2c_mapping.hpp"
+#include "reactor.hpp"
+#include "workpool.hpp"
+#include "chif_dispatch.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "i2c_xfer.hpp"
+#include "i2c_cache.hpp"
+#include "gpio_regs.hpp"
+#include "transport.hpp"
+#include "capture.hpp"
 
 // externs, mainly for debugging
 extern UINT8 platdef[PLATDEF_UPDATE_BUF_SZ + PLATDEF_BLOB_START];
@@ -51,8 +62,6 @@ extern void dump_apml_segments();
 
 char * version = (char*)"CHIF daemon v2.15";
 
-int EVError;
-
 /* Used only for debugging */
 void dumpheader(struct ChifPkt *pkt, bool recv_resp, int message_size)
 {
@@ -91,66 +100,264 @@ void dumpheader(struct ChifPkt *pkt, bool recv_resp, int message_size)
         dbPrintf("\nEND\n");
 }
 
-int Unknown_Response(void *recv, void *resp)
+#define CHIF_TXQ_DEPTH     16
+#define HOUSEKEEPING_MS    1000
+
+/* CHIF channel state, see transport.hpp for the descriptors */
+static struct {
+    struct chif_transport tp;
+    uint8_t recv[CHIF_PKT_MAX_SIZE];
+    uint8_t resp[CHIF_PKT_MAX_SIZE];
+} chif;
+
+/* responses waiting for the channel to become writable */
+static struct {
+    uint8_t buf[CHIF_TXQ_DEPTH][CHIF_PKT_MAX_SIZE];
+    int len[CHIF_TXQ_DEPTH];
+    int head;
+    int count;
+} txq;
+
+static void chif_txq_flush(void)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    long *ptr;
+    int n;
+
+    while (txq.count) {
+        n = write(chif.tp.tx_fd, txq.buf[txq.head], txq.len[txq.head]);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (n <= 0)
+            dbPrintf("CHIF: deferred write failed: %s\n", strerror(errno));
+        txq.head = (txq.head + 1) % CHIF_TXQ_DEPTH;
+        txq.count--;
+    }
+    reactor_mod_fd(chif.tp.rx_fd, EPOLLIN);
+}
 
-    respPkt->header.pkt_size = recvPkt->header.pkt_size + 4 ;
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = recvPkt->header.command |0x8000;
-    respPkt->header.service_id = 0;
+/* chif_send()
+ *
+ * Write a response packet.  If the channel would block the packet is queued
+ * and sent when the descriptor reports EPOLLOUT.
+ */
+static int chif_send(const uint8_t *pkt, int len)
+{
+    int n, slot;
+
+    if (txq.count == 0) {
+        n = write(chif.tp.tx_fd, pkt, len);
+        if (n > 0)
+            return n;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            dbPrintf("CHIF: write failed: %s\n", strerror(errno));
+            return n;
+        }
+    }
 
-    ptr=(long *)&respPkt->msg[0];
+    if (txq.count == CHIF_TXQ_DEPTH) {
+        printf("CHIF: transmit queue full, dropping response seq 0x%04x\n",
+               ((struct ChifPkt *)pkt)->header.sequence);
+        return -1;
+    }
 
-    *ptr = (long)0xFFFF0000;
-    return respPkt->header.pkt_size;
+    slot = (txq.head + txq.count) % CHIF_TXQ_DEPTH;
+    memcpy(txq.buf[slot], pkt, len);
+    txq.len[slot] = len;
+    if (txq.count++ == 0 && chif.tp.rx_fd == chif.tp.tx_fd)
+        reactor_mod_fd(chif.tp.rx_fd, EPOLLIN | EPOLLOUT);
+    return 0;
 }
 
-int UnknownHandler(void *recv, void *resp, int resp_len)
+/* chif_offload()
+ *
+ * Commands registered with CHIF_CMD_OFFLOAD can block for milliseconds
+ * (i2ctransfer fork/exec and retries, systemctl restart of smbios-mdrv2,
+ * journal + D-Bus event logging) and run on the worker pool so fast commands
+ * are not queued behind them.  While a ROM command is outstanding every
+ * later ROM command follows it through the pool so the SMBIOS upload
+ * sequence is processed in order.
+ */
+static bool chif_offload(struct ChifPkt *pkt)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
+    const struct chif_cmd *cmd;
 
-    memset(resp, 0, resp_len);
-    printf("UnknownHandler: command:0x%08x\n", recvPkt->header.command);
-    return Unknown_Response(recv, resp);
+    if (pkt->header.service_id == ROM_SERVICE_ID && workpool_pending(ROM_SERVICE_ID))
+        return true;
+
+    cmd = chif_lookup(pkt);
+    return cmd && (cmd->flags & CHIF_CMD_OFFLOAD);
+}
+
+#define CHIF_LANE_I2C   0x80000000      // | kernel bus
+
+/* jobs in the same lane never overlap: ROM shares one lane, I2C transactions
+ * are per kernel bus (bus, from smif_i2c_bus()) so different buses run in
+ * parallel, other SMIF commands are per command */
+static uint32_t chif_lane(struct ChifPkt *pkt, int bus)
+{
+    if (pkt->header.service_id == ROM_SERVICE_ID)
+        return (uint32_t)ROM_SERVICE_ID << 16;
+    if (bus >= 0)
+        return CHIF_LANE_I2C | bus;
+    return ((uint32_t)pkt->header.service_id << 16) | pkt->header.command;
 }
 
-int ChifHandler(void *recv, void *resp, int resp_len) {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-
-    memset(resp, 0, resp_len);
-
-    switch(recvPkt->header.service_id) {
-        case SMIF_SERVICE_ID:
-            return SmifHandler(recv, resp);
-        case ROM_SERVICE_ID:
-            return RomHandler(recv, resp, resp_len);
-        case TRITON_SERVICE_ID:
-            return TritonHandler(recv, resp);
-        case CHIF_SERVICE_ID_HEALTH:
-            return HealthHandler(recv, resp);
-        case CHIF_SERVICE_ID_BLACKBOX: // or AHS
-            return BlackBoxHandler(recv, resp);
-        case CHIF_SERVICE_ID_EMBMEDIA:
-            return EmbMediaHandler(recv, resp);
-        default:
-            return UnknownHandler(recv, resp, resp_len);
-            break;
+static void chif_respond(const uint8_t *recv, uint8_t *resp, int out_size, uint64_t handler_ns)
+{
+    uint64_t start;
+    int rc = 0;
+
+    CHIF_TRACE("tx svc 0x%02x cmd 0x%04x seq 0x%04x size %d handler %llu ns",
+               ((const struct ChifPkt *)recv)->header.service_id,
+               ((const struct ChifPkt *)recv)->header.command,
+               ((const struct ChifPkt *)recv)->header.sequence, out_size, handler_ns);
+
+    if(out_size<=0) {
+        //error handler
+        dbPrintf("ChifHandler error %d\n", out_size);
+        chif_stats_record((const struct ChifPkt *)recv, out_size, handler_ns, 0, 0);
+        return;
     }
 
-    return -1;
+    dumpheader((struct ChifPkt *)resp, 0, out_size);
+
+    if (gdbPrint) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    capture_write(CHIF_CAP_RESP, resp, out_size);
+    start = stats_now_ns();
+    rc = chif_send(resp, out_size);
+    chif_stats_record((const struct ChifPkt *)recv, out_size, handler_ns, rc, stats_now_ns() - start);
+    dbPrintf("Size written: %04x\n", (uint16_t)out_size);
+    dbPrintf("\n\n");
 }
 
-int main(int argc, char* argv[])
+/* completion of an offloaded command, called on the event loop */
+static void chif_job_done(struct chif_job *job)
 {
-    int fd;
-    int in_size;
+    chif_respond(job->recv, job->resp, job->out_size, job->handler_ns);
+}
+
+static void chif_process(int in_size)
+{
+    struct ChifPkt *pkt = (struct ChifPkt *)chif.recv;
+    uint64_t start;
     int out_size;
-    int write_size;
-    uint8_t recv[CHIF_PKT_MAX_SIZE];
-    uint8_t resp[CHIF_PKT_MAX_SIZE];
+
+    capture_write(CHIF_CAP_REQ, chif.recv, in_size);
+    dumpheader(pkt, 1, in_size);
+    CHIF_TRACE("rx svc 0x%02x cmd 0x%04x seq 0x%04x len %d", pkt->header.service_id,
+               pkt->header.command, pkt->header.sequence, in_size);
+
+    if (chif_offload(pkt)) {
+        // resolved once: the handler uses the bus of its lane even if the
+        // I2C map is reloaded before it runs
+        int bus = smif_i2c_bus(pkt);
+        uint32_t lane = chif_lane(pkt, bus);
+
+        if (workpool_submit(chif.recv, in_size, lane, bus) == 0) {
+            CHIF_TRACE("offload seq 0x%04x lane 0x%06x", pkt->header.sequence, lane);
+            return;
+        }
+    }
+
+    start = stats_now_ns();
+    out_size = ChifHandler(chif.recv, chif.resp, CHIF_PKT_MAX_SIZE);
+    chif_respond(chif.recv, chif.resp, out_size, stats_now_ns() - start);
+}
+
+/* chif_ready()
+ *
+ * Event loop callback for the CHIF channel.  Drains every queued request.
+ */
+static void chif_ready(int fd, uint32_t events, void *ctx)
+{
+    int in_size;
+
+    (void)ctx;
+
+    if ((events & EPOLLOUT) && txq.count)
+        chif_txq_flush();
+
+    if (!(events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+        return;
+
+    while (1) {
+        in_size = read(fd, chif.recv, CHIF_PKT_MAX_SIZE);
+        if (in_size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (in_size < 0 && errno == EINTR)
+            continue;
+        if(in_size<=0) {
+            dbPrintf("Size is less than 0...\n");
+            if (chif.tp.reconnect) {
+                // client went away, keep listening for the next one
+                reactor_del_fd(fd);
+                chif_transport_disconnect(&chif.tp);
+                txq.count = 0;
+                return;
+            }
+            reactor_stop();
+            return;
+        }
+        chif_process(in_size);
+    }
+}
+
+/* a client connected to a listening transport */
+static void chif_accept(int fd, uint32_t events, void *ctx)
+{
+    int old = chif.tp.rx_fd;
+
+    (void)fd;
+    (void)events;
+    (void)ctx;
+
+    if (chif_transport_accept(&chif.tp) < 0)
+        return;
+    if (old >= 0)
+        reactor_del_fd(old);
+    txq.count = 0;
+    dbPrintf("CHIF: client connected\n");
+    reactor_add_fd(chif.tp.rx_fd, EPOLLIN, chif_ready, NULL);
+}
+
+static int chif_open(const char *spec)
+{
+    if (chif_transport_open(&chif.tp, spec) < 0)
+        return -1;
+
+    if (chif.tp.type == CHIF_TRANSPORT_UNIX)
+        return reactor_add_fd(chif.tp.dev_fd, EPOLLIN, chif_accept, NULL);
+    return reactor_add_fd(chif.tp.rx_fd, EPOLLIN, chif_ready, NULL);
+}
+
+static void housekeeping(int timer, void *ctx)
+{
+    (void)timer;
+    (void)ctx;
+
+    fflush(stdout);
+    fflush(stderr);
+    capture_flush();
+}
+
+static void shutdown_signal(int signo, int value, void *ctx)
+{
+    (void)value;
+    (void)ctx;
+
+    printf("CHIF: caught signal %d, exiting\n", signo);
+    reactor_stop();
+}
+
+int main(int argc, char* argv[])
+{
+    const char *transport = CHIF_DEFAULT_TRANSPORT;
+    const char *record = NULL;
+    const char *i2c_backend = I2C_DEFAULT_BACKEND;
+    unsigned int i2c_cache_ms = 0;
+    int i;
 
     if (argc > 1)
     {
@@ -183,12 +390,36 @@ int main(int argc, char* argv[])
             dump_apml_segments();
             exit(0);
         }
+    }
 
-        if (strcmp(argv[1], "-dbp") == 0) {
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-dbp") == 0) {
             gdbPrint = true;
         }
+        else if (strcmp(argv[i], "-trace") == 0) {
+            gChifTrace = true;
+        }
+        else if (strcmp(argv[i], "-offline") == 0) {
+            gChifOffline = true;
+        }
+        else if (strcmp(argv[i], "-i2c") == 0 && i + 1 < argc) {
+            i2c_backend = argv[++i];
+        }
+        else if (strcmp(argv[i], "-i2ccache") == 0 && i + 1 < argc) {
+            i2c_cache_ms = strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-evcommit") == 0 && i + 1 < argc) {
+            setEVCommitWindow(strtoul(argv[++i], NULL, 0));
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            transport = argv[++i];
+        }
+        else if (strcmp(argv[i], "-rec") == 0 && i + 1 < argc) {
+            record = argv[++i];
+        }
         else {
             printf("Bad argument\n");
+            printf("usage: %s [-dbp] [-trace] [-offline] [-i2c dev|sim:CONFIG] [-i2ccache MS] [-evcommit MS] [-t dev:PATH|unix:PATH|fd:N|file:CAPTURE] [-rec CAPTURE]\n", argv[0]);
             exit(1);
         }
     }
@@ -197,39 +428,43 @@ int main(int argc, char* argv[])
 
     init_platdef();
     load_i2c_mapping();
+    if (i2c_backend_open(i2c_backend) < 0)
+        exit(1);
+    if (i2c_cache_ms) {
+        // DIMMs of the last boot until the next SMBIOS download
+        smbios_cfg_read_into_globalvar();
+        i2c_cache_policy_smbios();
+        i2c_cache_enable(i2c_cache_ms);
+    }
     init_smif();
-
-    fd = open("/dev/chif24", O_RDWR);
     initEV();
- 
-    while(1) {
-        in_size = read(fd, recv, CHIF_PKT_MAX_SIZE);
-        if(in_size<=0) {
-            dbPrintf("Size is less than 0...\n");
-            break;
-        }
-        dumpheader((struct ChifPkt *)recv, 1, in_size);
-
-        out_size = ChifHandler(recv, resp, CHIF_PKT_MAX_SIZE);
-
-        if(out_size<=0) {
-            //error handler
-            dbPrintf("ChifHandler error %d\n", out_size);
-            continue;
-        }
-
-        dumpheader((struct ChifPkt *)resp, 0, out_size);
-
-        fflush(stdout);
-        fflush(stderr);
-        write_size = write(fd, resp, out_size);
-        dbPrintf("Size written: %04x\n", (uint16_t)out_size);
-        dbPrintf("\n\n");
-        if(write_size<=0) {
-            //printf("Size is less than 0...\n");
-            continue;
-        }
-    }
 
-    close(fd);
+    signal(SIGPIPE, SIG_IGN);
+    if (reactor_init() < 0)
+        exit(1);
+    reactor_add_signal(SIGTERM, shutdown_signal, NULL);
+    reactor_add_signal(SIGINT, shutdown_signal, NULL);
+    reactor_add_signal(SIGUSR1, chif_stats_signal, NULL);
+    reactor_add_signal(SIGUSR2, chif_trace_signal, NULL);
+    reactor_add_timer(HOUSEKEEPING_MS, HOUSEKEEPING_MS, housekeeping, NULL);
+    i2c_mapping_watch();
+    gpio_regs_init();
+
+    if (workpool_init(WORKPOOL_WORKERS, ChifHandler, chif_job_done) < 0)
+        exit(1);
+    if (record && capture_open(record) < 0)
+        exit(1);
+    if (chif_open(transport) < 0)
+        exit(1);
+
+    reactor_run();
+
+    workpool_drain();
+    workpool_shutdown();
+    closeEV();
+    i2c_xfer_close();
+    gpio_regs_close();
+    capture_close();
+    fflush(stdout);
+    chif_transport_close(&chif.tp);
 }
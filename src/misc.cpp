@@ -22,98 +22,117 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <iostream>
 #include <cstdarg>
 #include "misc.hpp"
 #include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "chif_reply.hpp"
 
 bool gdbPrint=false;
+bool gChifOffline=false;
 
 int GenResponse(void *recv, void *resp, uint8_t service_id)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_gen *respMsg = (struct pkt_gen *)&respPkt->msg[0];
-
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader);
-	respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = recvPkt->msg[0];
-	respPkt->header.service_id = service_id;
-    respMsg->ErrorCode = 0;
-	return respPkt->header.pkt_size;
+
+	// header only, the acknowledge carries no payload
+	Reply<> reply(recv, resp, recvPkt->msg[0], service_id);
+	return reply.send();
 }
 
 
-int EmbMediaHandler(void *recv, void *resp)
+static int EmbMedia_Response(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
+	return GenResponse(recv, resp, CHIF_SERVICE_ID_EMBMEDIA);
+}
 
-	dbPrintf("EmbMediaHandler: command:0x%08x\n", recvPkt->header.command);
-
-	switch(recvPkt->header.command) {
-        case 0x01:
-        case 0x04:
-		case 0x06:
-				return GenResponse(recv, resp, CHIF_SERVICE_ID_EMBMEDIA);
-		default:
-			//other rom command doesn't need to response
-			return -1;
-	}
+static int Health_Response(void *recv, void *resp)
+{
+	return GenResponse(recv, resp, CHIF_SERVICE_ID_HEALTH);
 }
 
+static int BlackBox_Response(void *recv, void *resp)
+{
+	return GenResponse(recv, resp, CHIF_SERVICE_ID_BLACKBOX);
+}
+
+/* other commands don't need a response (or respond with error) */
+static int Misc_NoResponse(void *recv, void *resp)
+{
+	(void)recv;
+	(void)resp;
+	return -1;
+}
+
+static constexpr struct chif_cmd embmedia_cmds[] = {
+	CHIF_CMD(0x01, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, EmbMedia_Response, "EmbMedia Acknowledge"),
+	CHIF_CMD(0x04, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, EmbMedia_Response, "EmbMedia Acknowledge"),
+	CHIF_CMD(0x06, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, EmbMedia_Response, "EmbMedia Acknowledge"),
+};
+
+CHIF_SERVICE(embmedia_service, CHIF_SERVICE_ID_EMBMEDIA, "embmedia", chif_key_command, embmedia_cmds, Misc_NoResponse);
+
 #define EH_INTF_TYPE_RESERVED             0x00
 #define EH_INTF_TYPE_NVRAM_SECURE         0x11
 #define EH_INTF_TYPE_RESET_STATUS         0x12
 #define EH_INTF_TYPE_APML_VERSION         0x1C
 #define EH_INTF_TYPE_POST_FLAGS           0x1D
 
-
-int HealthHandler(void *recv, void *resp)
+/* health requests are dispatched on the interface type in the first payload byte */
+static uint16_t Health_Key(const struct ChifPkt *pkt)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-
-	dbPrintf("HealthHandler: command:0x%08x\n", recvPkt->header.command);
-
-    // see eh_intf_dispatcher() function in iLO health/sr/eh_intf.c for why we return data as 0 for all these
-	switch(recvPkt->msg[0]) {
-        case EH_INTF_TYPE_RESERVED:
-        case EH_INTF_TYPE_RESET_STATUS:
-        case EH_INTF_TYPE_NVRAM_SECURE:
-        case EH_INTF_TYPE_APML_VERSION:
-        case EH_INTF_TYPE_POST_FLAGS:
-				return GenResponse(recv, resp, CHIF_SERVICE_ID_HEALTH);
-		default:
-			//other, respond with error
-			return -1;
-	}
+	return pkt->msg[0];
 }
 
-int BlackBoxHandler(void *recv, void *resp)
-{
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
+// see eh_intf_dispatcher() function in iLO health/sr/eh_intf.c for why we return data as 0 for all these
+static constexpr struct chif_cmd health_cmds[] = {
+	CHIF_CMD(EH_INTF_TYPE_RESERVED, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, Health_Response, "Reserved"),
+	CHIF_CMD(EH_INTF_TYPE_NVRAM_SECURE, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, Health_Response, "NVRAM Secure"),
+	CHIF_CMD(EH_INTF_TYPE_RESET_STATUS, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, Health_Response, "Reset Status"),
+	CHIF_CMD(EH_INTF_TYPE_APML_VERSION, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, Health_Response, "APML Version"),
+	CHIF_CMD(EH_INTF_TYPE_POST_FLAGS, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, Health_Response, "POST Flags"),
+};
 
-	dbPrintf("BlackBoxHandler: command:0x%08x\n", recvPkt->header.command);
+CHIF_SERVICE(health_service, CHIF_SERVICE_ID_HEALTH, "health", Health_Key, health_cmds, Misc_NoResponse);
 
-	switch(recvPkt->header.command) {
-        case 0x00:
-        case 0x8000:
-				return GenResponse(recv, resp, CHIF_SERVICE_ID_BLACKBOX);
-		default:
-            //other, respond with error
-			return -1;
-	}
+/* the response form (0x8000) of the blackbox command is accepted as a request too */
+static uint16_t BlackBox_Key(const struct ChifPkt *pkt)
+{
+	return pkt->header.command & 0x7fff;
 }
 
-/* Prints debug output if enabled at the command line */
-void dbPrintf(const char *format, ...)
+static constexpr struct chif_cmd blackbox_cmds[] = {
+	CHIF_CMD(0x00, 0, struct pkt_gen, CHIF_CMD_IDEMPOTENT, BlackBox_Response, "BlackBox Acknowledge"),
+};
+
+CHIF_SERVICE(blackbox_service, CHIF_SERVICE_ID_BLACKBOX, "blackbox", BlackBox_Key, blackbox_cmds, Misc_NoResponse);
+
+/* Prints debug output, dbPrintf() only calls it when enabled at the command line */
+void chif_dbprintf(const char *format, ...)
 {
-    if (!gdbPrint) {
-        return;
-    }
     va_list args;
     va_start(args, format);
     vprintf(format, args);
     va_end(args);
 }
 
+/* chif_path()
+ *
+ * Prefix a state file path with $CHIF_ROOT so the daemon, the tools and the
+ * benchmarks can run against a scratch directory.  The result is never freed;
+ * use CHIF_PATH() so each call site resolves its path once.
+ */
+const char *chif_path(const char *path)
+{
+    const char *root = getenv("CHIF_ROOT");
+    char *s;
+
+    if (!root || !*root)
+        return path;
+    if (asprintf(&s, "%s%s", root, path) < 0)
+        return path;
+    return s;
+}
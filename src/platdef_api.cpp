@@ -730,7 +730,6 @@ platdef_smif_rc platdef_Download_specific_data (UINT32 *data_size, UINT32 timest
         count_in = *req_count;
         count_out = 0;
         *data_size = 0;
-        memset(resp,0,resp_buf_size);
 
         for (i=0;i<count_in;i++) {
             if (curr_buf_offset + req_data[i].length > resp_buf_size) {
@@ -0,0 +1,292 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+#include "reactor.hpp"
+#include "misc.hpp"
+
+#define REACTOR_MAX_EVENTS  16
+
+enum {
+    REACTOR_FREE = 0,
+    REACTOR_FD,
+    REACTOR_TIMER,
+    REACTOR_SIGNAL
+};
+
+struct reactor_handler {
+    int kind;
+    int fd;
+    reactor_fd_cb fd_cb;
+    reactor_timer_cb timer_cb;
+    void *ctx;
+};
+
+struct reactor_sig {
+    reactor_signal_cb cb;
+    void *ctx;
+};
+
+static int epfd = -1;
+static int sigfd = -1;
+static sigset_t sigmask;
+static volatile bool running;
+static struct reactor_handler handlers[REACTOR_MAX_HANDLERS];
+static struct reactor_sig signals[NSIG];
+
+static struct reactor_handler *reactor_find(int fd)
+{
+    int i;
+
+    for (i = 0; i < REACTOR_MAX_HANDLERS; i++) {
+        if (handlers[i].kind != REACTOR_FREE && handlers[i].fd == fd)
+            return &handlers[i];
+    }
+    return NULL;
+}
+
+static struct reactor_handler *reactor_register(int kind, int fd, uint32_t events)
+{
+    struct epoll_event ev;
+    int i;
+
+    for (i = 0; i < REACTOR_MAX_HANDLERS; i++) {
+        if (handlers[i].kind == REACTOR_FREE)
+            break;
+    }
+    if (i == REACTOR_MAX_HANDLERS) {
+        printf("reactor: handler table full\n");
+        return NULL;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = &handlers[i];
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        dbPrintf("reactor: epoll_ctl add fd %d failed: %s\n", fd, strerror(errno));
+        return NULL;
+    }
+
+    memset(&handlers[i], 0, sizeof(handlers[i]));
+    handlers[i].kind = kind;
+    handlers[i].fd = fd;
+    return &handlers[i];
+}
+
+int reactor_init(void)
+{
+    if (epfd >= 0)
+        return 0;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        printf("reactor: epoll_create1 failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    memset(handlers, 0, sizeof(handlers));
+    memset(signals, 0, sizeof(signals));
+    sigemptyset(&sigmask);
+    return 0;
+}
+
+int reactor_add_fd(int fd, uint32_t events, reactor_fd_cb cb, void *ctx)
+{
+    struct reactor_handler *h;
+
+    h = reactor_register(REACTOR_FD, fd, events);
+    if (!h)
+        return -1;
+
+    h->fd_cb = cb;
+    h->ctx = ctx;
+    return 0;
+}
+
+int reactor_mod_fd(int fd, uint32_t events)
+{
+    struct reactor_handler *h = reactor_find(fd);
+    struct epoll_event ev;
+
+    if (!h)
+        return -1;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = h;
+    return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+int reactor_del_fd(int fd)
+{
+    struct reactor_handler *h = reactor_find(fd);
+
+    if (!h)
+        return -1;
+
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+    h->kind = REACTOR_FREE;
+    return 0;
+}
+
+int reactor_arm_timer(int timer, unsigned int first_ms, unsigned int interval_ms)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = first_ms / 1000;
+    its.it_value.tv_nsec = (first_ms % 1000) * 1000000L;
+    its.it_interval.tv_sec = interval_ms / 1000;
+    its.it_interval.tv_nsec = (interval_ms % 1000) * 1000000L;
+
+    return timerfd_settime(timer, 0, &its, NULL);
+}
+
+int reactor_add_timer(unsigned int first_ms, unsigned int interval_ms,
+                      reactor_timer_cb cb, void *ctx)
+{
+    struct reactor_handler *h;
+    int tfd;
+
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) {
+        printf("reactor: timerfd_create failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    h = reactor_register(REACTOR_TIMER, tfd, EPOLLIN);
+    if (!h) {
+        close(tfd);
+        return -1;
+    }
+    h->timer_cb = cb;
+    h->ctx = ctx;
+
+    if (first_ms && reactor_arm_timer(tfd, first_ms, interval_ms) < 0) {
+        reactor_del_fd(tfd);
+        close(tfd);
+        return -1;
+    }
+    return tfd;
+}
+
+int reactor_add_signal(int signo, reactor_signal_cb cb, void *ctx)
+{
+    if (signo <= 0 || signo >= NSIG)
+        return -1;
+
+    signals[signo].cb = cb;
+    signals[signo].ctx = ctx;
+
+    // Block normal delivery; threads created after this point inherit the mask.
+    sigaddset(&sigmask, signo);
+    if (sigprocmask(SIG_BLOCK, &sigmask, NULL) < 0) {
+        printf("reactor: sigprocmask failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (sigfd >= 0) {
+        // updating the mask of an existing signalfd
+        return (signalfd(sigfd, &sigmask, 0) < 0) ? -1 : 0;
+    }
+
+    sigfd = signalfd(-1, &sigmask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sigfd < 0) {
+        printf("reactor: signalfd failed: %s\n", strerror(errno));
+        return -1;
+    }
+    if (!reactor_register(REACTOR_SIGNAL, sigfd, EPOLLIN)) {
+        close(sigfd);
+        sigfd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static void reactor_dispatch_signals(void)
+{
+    struct signalfd_siginfo si;
+
+    while (read(sigfd, &si, sizeof(si)) == (ssize_t)sizeof(si)) {
+        if (si.ssi_signo < NSIG && signals[si.ssi_signo].cb) {
+            signals[si.ssi_signo].cb(si.ssi_signo, si.ssi_int, signals[si.ssi_signo].ctx);
+        }
+    }
+}
+
+static void reactor_dispatch(struct reactor_handler *h, uint32_t events)
+{
+    uint64_t expirations;
+
+    switch (h->kind) {
+        case REACTOR_FD:
+            h->fd_cb(h->fd, events, h->ctx);
+            break;
+
+        case REACTOR_TIMER:
+            if (read(h->fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                h->timer_cb(h->fd, h->ctx);
+            }
+            break;
+
+        case REACTOR_SIGNAL:
+            reactor_dispatch_signals();
+            break;
+
+        default:
+            // handler was removed by an earlier callback in this batch
+            break;
+    }
+}
+
+int reactor_run(void)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    int n, i;
+
+    running = true;
+    while (running) {
+        n = epoll_wait(epfd, events, REACTOR_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            printf("reactor: epoll_wait failed: %s\n", strerror(errno));
+            return -1;
+        }
+
+        for (i = 0; i < n && running; i++) {
+            reactor_dispatch((struct reactor_handler *)events[i].data.ptr, events[i].events);
+        }
+    }
+    return 0;
+}
+
+void reactor_stop(void)
+{
+    running = false;
+}
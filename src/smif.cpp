@@ -22,6 +22,7 @@
 #include <sys/types.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <errno.h>
 #include <string>
 #include <cstring>
 #include "ev.hpp"
@@ -41,10 +42,21 @@
 #include "i2c_topology.hpp"
 #include "i2c_return_codes.hpp"
 #include "i2c_mapping.hpp"
+#include "i2c_xfer.hpp"
+#include "i2c_cache.hpp"
+#include "i2c_health.hpp"
+#include "i2c_stats.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 #include "gpio.h"
+#include "gpio_regs.hpp"
 #include "DataExtract.h"
 #include "logs.h"
 #include "misc.hpp"
+#include "chif_dispatch.hpp"
+#include "chif_reply.hpp"
+#include "chif_template.hpp"
+#include "workpool.hpp"
 
 #define EVT_IML 0x01
 #define EVT_IEL 0x02
@@ -214,6 +226,32 @@ struct pkt_8072 {
 	uint8_t   data[32];
 } __attribute__ ((packed));
 
+#define I2C_BATCH_QUERY     0x01    // run nothing, report the limits
+#define I2C_BATCH_CONTINUE  0x02    // go on after a failed transaction
+#define I2C_BATCH_MAX_TXNS  255
+
+struct pkt_007a {
+	uint32_t  reserved;
+	uint8_t   magic[8];
+	uint8_t   segment;
+	uint8_t   flags;
+	uint8_t   count;
+	uint8_t   reserved2;
+	uint8_t   txn[1];           // count x { address, write_len, read_len, data[write_len] }
+} __attribute__ ((packed));
+
+struct pkt_807a {
+	uint32_t  ErrorCode;
+	uint8_t   segment;
+	uint8_t   flags;
+	uint8_t   count;            // results below
+	uint8_t   reserved;
+	uint16_t  max_txns;         // limits, always filled in
+	uint16_t  max_len;          // bytes one transaction writes or reads
+	uint16_t  max_data;         // bytes of results that fit a response
+	uint8_t   result[1];        // count x { status, read_len, data[read_len] }
+} __attribute__ ((packed));
+
 struct pkt_0088 {
     uint32_t  operation;
 #define SMIF_GET_MEMID  (1) // read a byte from the memid scan chain
@@ -613,6 +651,9 @@ void init_smif(void) {
 
         fclose(fp);
     }
+
+    // 0002 and friends answer from templates built from the data above
+    chif_template_init(&smif_service);
 }
 
 /*
@@ -625,14 +666,8 @@ void init_smif(void) {
  */
 int SmifPkt_0002(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-	struct pkt_8002 *respMsg = (struct pkt_8002 *)&respPkt->msg[0];
-
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8002);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8002;
-	respPkt->header.service_id = 0;
+	Reply<struct pkt_8002> reply(recv, resp, 0x8002);
+	struct pkt_8002 *respMsg = reply.msg();
 
 	respMsg->ErrorCode = 0;
 
@@ -645,7 +680,7 @@ int SmifPkt_0002(void *recv, void *resp)
 	respMsg->chip_id = 0;  // not used by BIOS.
 	strncpy((char *)respMsg->board_serial_number, gSerialNumber, sizeof(respMsg->board_serial_number));
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 /*
@@ -653,14 +688,8 @@ int SmifPkt_0002(void *recv, void *resp)
  */
 int smifpkt_0006 (void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_8006 *respMsg = (struct pkt_8006 *)&respPkt->msg[0];
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8006);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8006;
-    respPkt->header.service_id = 0;
+    Reply<struct pkt_8006> reply(recv, resp, 0x8006);
+    struct pkt_8006 *respMsg = reply.msg();
 
     respMsg->ErrorCode = 0;
 
@@ -675,6 +704,7 @@ int smifpkt_0006 (void *recv, void *resp)
     strncpy(ifr.ifr_name, "eth0", IFNAMSIZ-1);
 
     ioctl(fd, SIOCGIFADDR, &ifr);
+    close(fd);
 
     dbPrintf("Network data: %s %x ", inet_ntoa(((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr),
           ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr.s_addr);
@@ -688,7 +718,7 @@ int smifpkt_0006 (void *recv, void *resp)
     strncpy(&respMsg->cfg.iface[0].domain_name[0], gDomainName, sizeof(respMsg->cfg.iface[0].domain_name));
     respMsg->cfg.iface[0].kernel = 0;  // not unused by BIOS.
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 /* 
@@ -696,17 +726,12 @@ int smifpkt_0006 (void *recv, void *resp)
  */
 int SmifPkt_0008(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+    Reply<struct pkt_8008> reply(recv, resp, 0x8008);
  //   struct pkt_0008 *recvMsg = (struct pkt_0008 *)&recvPkt->msg[0];
-    struct pkt_8008 *respMsg = (struct pkt_8008 *)&respPkt->msg[0];
+    struct pkt_8008 *respMsg = reply.msg();
 
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8008);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8008;
-    respPkt->header.service_id = 0;
 	respMsg->ErrorCode = 0x00;
-	return respPkt->header.pkt_size;
+	return reply.send();
 
 }
 
@@ -749,18 +774,12 @@ RTC_LEGACY_TIME * rtc_legacy_localtime(
  */
 int SmifPkt_0055(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-	struct pkt_8055 *respMsg = (struct pkt_8055 *)&respPkt->msg[0];
+	Reply<struct pkt_8055> reply(recv, resp, 0x8055);
+	struct pkt_8055 *respMsg = reply.msg();
     time_t now;
     RTC_LEGACY_TIME rtc_legacy_time;
 //    TZ_STORED tz;
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8055);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8055;
-	respPkt->header.service_id = 0;
-
 	respMsg->ErrorCode = 0;
 
     time(&now);
@@ -770,7 +789,7 @@ int SmifPkt_0055(void *recv, void *resp)
     respMsg->datetime = rtc_legacy_time.datetime;
     respMsg->daylight = rtc_legacy_time.isdst ? 1 : 0;
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 /*
@@ -778,14 +797,8 @@ int SmifPkt_0055(void *recv, void *resp)
  */
 int SmifPkt_0063(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-	struct pkt_8063 *respMsg = (struct pkt_8063 *)&respPkt->msg[0];
-
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8063);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8063;
-	respPkt->header.service_id = 0;
+	Reply<struct pkt_8063> reply(recv, resp, 0x8063);
+	struct pkt_8063 *respMsg = reply.msg();
 
 	respMsg->ErrorCode = 0;
 	respMsg->nic_settings = 0x03;
@@ -827,7 +840,7 @@ int SmifPkt_0063(void *recv, void *resp)
 
 	close(fd);
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 /* 
@@ -835,14 +848,8 @@ int SmifPkt_0063(void *recv, void *resp)
  */
 int SmifPkt_006e(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_806e *respMsg = (struct pkt_806e *)&respPkt->msg[0];
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8063);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x806e;
-    respPkt->header.service_id = 0;
+    Reply<struct pkt_806e> reply(recv, resp, 0x806e);
+    struct pkt_806e *respMsg = reply.msg();
 
     respMsg->ErrCode = 0x1;
     respMsg->reserved2 = 0x0;
@@ -850,7 +857,7 @@ int SmifPkt_006e(void *recv, void *resp)
     respMsg->installable = 0x21;
     respMsg->status = 0x1;
  
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 /* 
@@ -858,17 +865,12 @@ int SmifPkt_006e(void *recv, void *resp)
  */
 int SmifPkt_0050(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+    Reply<struct pkt_8050> reply(recv, resp, 0x8050);
 //    struct pkt_0050 *recvMsg = (struct pkt_0050 *)&recvPkt->msg[0];
-    struct pkt_8050 *respMsg = (struct pkt_8050 *)&respPkt->msg[0];
+    struct pkt_8050 *respMsg = reply.msg();
 	uint32_t scratchpad=0x00070101; // content of 0x802000a0
 	uint32_t tmp;
 
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8050);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8050;
-    respPkt->header.service_id = 0;
 	respMsg->ErrorCode = 0;
 	respMsg->FlashSectorSize = 0x10000;
 
@@ -892,7 +894,7 @@ int SmifPkt_0050(void *recv, void *resp)
 	respMsg->flashStage=0;
 	respMsg->flashPercent=0;
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 };
 
 void dump_apml_segments(){
@@ -906,19 +908,18 @@ void dump_apml_segments(){
 
 static int select_bus(uint8_t segment)
 {
-    int i;
+    // see load_i2c_mapping(), we expect a software mux on the linux kernel side
+    return i2c_map_get()->segment_bus[segment];
+}
 
-    // re-route the request to the relevant bus
-    for ( i = 0 ; i < i2cAllocatedEntries ; i++ ) {
-	    if ((apml_segments[segment].MuxControl.CPLD.Byte == i2cSystemEntries[i].cpldReg ) &&
-		(apml_segments[segment].MuxControl.CPLD.SelectMask == i2cSystemEntries[i].RegVal )) {
-	            return i2cSystemEntries[i].i2cKernelSegment;
-	    }
-    }
+/* the kernel bus of an I2C request: on a worker the one its lane was picked
+ * by when it was queued, so that jobs for one bus never run side by side
+ * across a reload of the I2C map; looked up now when run inline */
+static int request_bus(uint8_t segment)
+{
+    const struct chif_job *job = workpool_current();
 
-    // We expect a software mux implementation on the linux kernel side
-    dbPrintf("select_bus: no match for segment %d \n", segment);
-    return -1;
+    return job ? job->i2c_bus : select_bus(segment);
 }
 
 
@@ -926,6 +927,10 @@ static int select_bus(uint8_t segment)
  *
  * Note: it is not the intention for Agents or other routine customer-facing tools to use this support.
  *
+ * The transaction is one I2C_RDWR ioctl on the bus the segment maps to (see i2c_xfer.hpp);
+ * errors are the I2C_* codes of i2c_return_codes.hpp.  A device that keeps failing is answered
+ * with its last error without touching the bus until its backoff runs out (see i2c_health.hpp).
+ *
  * 0x8072 - I2C Transaction Response
  * errorcode values:
  * 0:    Success
@@ -959,157 +964,208 @@ static int select_bus(uint8_t segment)
  * 121:  I2C_PROTOCOL_ERR     Detected a protocol error.  Reset the bus.
  */
 #define MAX_I2C_RETRIES 1
+
+/* smif_i2c_transaction()
+ *
+ * One transaction to the 7-bit address addr on bus, shared by 0x0072 and
+ * 0x007a: the read cache, the backoff of failing devices, one retry, the
+ * statistics.  Returns I2C_SUCCESS or I2C_SEGMENT_DOES_NOT_EXIST, what the
+ * i2ctransfer version answered for any failure and BIOS probes absent
+ * devices with; the code i2c_xfer_errno() gave is only kept for the
+ * statistics, the backoff and the trace.
+ */
+static int smif_i2c_transaction(uint8_t segment, int bus, uint8_t addr, const uint8_t *wbuf,
+                                uint8_t wlen, uint8_t *rbuf, uint8_t rlen)
+{
+    bool retry_ok;
+    uint64_t t0;
+    int retry, rc;
+
+    dbPrintf("    bus %d w%d@0x%02x r%d\n", bus, wlen, addr, rlen);
+    if (i2c_cache_get(segment, bus, addr, wbuf, wlen, rbuf, rlen)) {
+        dbPrintf("    from the I2C read cache\n");
+        return I2C_SUCCESS;
+    }
+    if ((rc = i2c_health_check(bus, addr, &retry_ok)) != I2C_SUCCESS) {
+        dbPrintf("    device backed off, error %d\n", rc);
+        CHIF_TRACE("i2c seg %02x bus %d addr 0x%02x backed off rc %d", segment, bus, addr, rc);
+        return I2C_SEGMENT_DOES_NOT_EXIST;
+    }
+
+    t0 = stats_now_ns();
+    for (retry = 0; ; retry++) {
+        rc = i2c_xfer(bus, addr, wbuf, wlen, rbuf, rlen);
+        if (rc == I2C_SUCCESS || rc == I2C_BAD_ARGUMENT || rc == I2C_SEGMENT_DOES_NOT_EXIST ||
+            !retry_ok || retry >= MAX_I2C_RETRIES)
+            break;
+
+        // delay before retrying
+        dbPrintf("I2C transaction failed (%d), retry: %d\n", rc, retry + 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    i2c_stats_record(segment, bus, addr, wlen, rlen, retry, rc, stats_now_ns() - t0);
+    i2c_health_record(segment, bus, addr, rc);
+    i2c_cache_update(segment, bus, addr, wbuf, wlen, rbuf, rlen, rc);
+
+    if (rc != I2C_SUCCESS) {
+        printf("Unable to access I2C device at bus: %d addr: %02x, error %d\n", bus, addr, rc);
+        return I2C_SEGMENT_DOES_NOT_EXIST;
+    }
+    return I2C_SUCCESS;
+}
+
 int SmifPkt_0072(void *recv, void *resp)
 {
     struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+    Reply<struct pkt_8072> reply(recv, resp, 0x8072);
     struct pkt_0072 *recvMsg = (struct pkt_0072 *)&recvPkt->msg[0];
-    struct pkt_8072 *respMsg = (struct pkt_8072 *)&respPkt->msg[0];
-    std::string i2cTransferCmd = "i2ctransfer -y -f ";
+    struct pkt_8072 *respMsg = reply.msg();
 
     dbPrintf("pkt_0072->address=0x%02x\n", (uint8_t)recvMsg->address);
     dbPrintf("pkt_0072->segment=0x%02x\n", recvMsg->segment);
     dbPrintf("pkt_0072->write_len=0x%02x\n", recvMsg->write_len);
     dbPrintf("pkt_0072->read_len=0x%02x\n", recvMsg->read_len);
 
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8072);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8072;
-    respPkt->header.service_id = 0;
-
     if(recvMsg->address == 0xffff && recvMsg->segment == 0xff) {
         printf("Invalid I2C address = %c\n", recvMsg->data[0]);
         respMsg->ErrorCode = I2C_BAD_ARGUMENT;
 
+    } else if (recvMsg->write_len > sizeof(recvMsg->data) || recvMsg->read_len > sizeof(respMsg->data)) {
+        respMsg->ErrorCode = I2C_SIZE_GREATER_THAN_MAX_STANDARD_TRANSACT_ERROR;
+
     } else {
         // Select the bus first
         int bus;
 
-        bus = select_bus(recvMsg->segment);
+        bus = request_bus(recvMsg->segment);
         if (bus == -1) {
             respMsg->ErrorCode = I2C_SEGMENT_DOES_NOT_EXIST;
 
         } else {
-            int retry=0;
-            int i;
-            char temp[256]; // hold at least 32 hex printed like '0xcb '
-
-            // Start building the raw command
-            // first add the bus, number of bytes to write, and the 7-bit I2C address
-            memset(temp, 0, sizeof(temp));
-	        sprintf(temp, "%d w%d@0x%02x", bus, recvMsg->write_len, (uint8_t)(recvMsg->address >> 1));
-            i2cTransferCmd += temp;
-
-            // Next add the raw bytes to be written
-            memset(temp, 0, sizeof(temp));
-            for (i=0; i < recvMsg->write_len; i++) {
-                sprintf(&temp[i*5], " 0x%02x", recvMsg->data[i]);
-            }
-            i2cTransferCmd += temp;
-
-            // last add the number of bytes to read back, if any.
-            if (recvMsg->read_len) {
-                memset(temp, 0, sizeof(temp));
-                sprintf(temp, " r%d", recvMsg->read_len);
-                i2cTransferCmd += temp;
-            }
-
-            // e.g. i2ctransfer -y -f 21 -w4@0x40 0x34 0xbf 0x00 0xe8
-
-            dbPrintf("    %s\n", i2cTransferCmd.c_str());
-            while (retry++ <= MAX_I2C_RETRIES) {
-
-                errno = 0;
-                // issue the command and get the output
-                FILE *cmd = popen(i2cTransferCmd.c_str(), "r");
-                if (cmd) {
-                    if (recvMsg->read_len) {
-                        memset(temp, 0, sizeof(temp));
-                        // check for output
-                        if (fgets(temp, sizeof(temp), cmd) !=NULL) {
-                            char * hexString;
-                            // get each hex byte value and add it to the return data
-                            dbPrintf("%s", temp);
-                            hexString = strtok(temp, " ");
-                            for (i=0; hexString != NULL; i++) {
-                                if (strcmp(hexString, "Error:") == 0) {
-                                    dbPrintf("%s failed, retry: %d, ", hexString, retry);
-                                    respMsg->ErrorCode = I2C_GENERAL_ERROR;
-                                    break;
-                                }
-                                respMsg->data[i] = std::stoi(hexString, 0, 16);
-                                hexString = strtok(NULL, " ");
-                                retry = 0;
-                                respMsg->ErrorCode = I2C_SUCCESS;
-                            }
-                            hexdump(respMsg->data, i);
-                            dbPrintf("\n");
-                        } /* fgets */
-                    } else {
-                        dbPrintf("No output expected for i2ctransfer command\n");
-                        retry = 0;
-                        respMsg->ErrorCode = I2C_SUCCESS;
-                    }
-                    (void) pclose(cmd);
-
-                    if (retry) {
-                        // delay before retrying
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                        continue;
-                    } else {
-                        break;
-                    }
+            int rc;
 
-                } else {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                    dbPrintf("cmd is Null, popen call failed: %s\n", i2cTransferCmd.c_str());
-                }
-            }
-
-            if (retry > MAX_I2C_RETRIES) {
-                dbPrintf("All retries failed\n");
-                printf("Unable to access I2C device at bus: %d addr: %02x\n", bus, (uint8_t)(recvMsg->address >> 1));
-                respMsg->ErrorCode = I2C_SEGMENT_DOES_NOT_EXIST;
-            }
-            if (respMsg->ErrorCode == I2C_SUCCESS) {
+            rc = smif_i2c_transaction(recvMsg->segment, bus, (uint8_t)(recvMsg->address >> 1),
+                                      recvMsg->data, recvMsg->write_len,
+                                      respMsg->data, recvMsg->read_len);
+            if (rc == I2C_SUCCESS) {
+                hexdump(respMsg->data, recvMsg->read_len);
                 respMsg->address = recvMsg->address;
                 respMsg->segment = recvMsg->segment;
                 respMsg->read_len = recvMsg->read_len;
                 respMsg->ErrorCode = 0;
+            } else {
+                memset(respMsg->data, 0, sizeof(respMsg->data));
+                respMsg->ErrorCode = rc;
             }
         }
     }
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
-#define GPIO_MEMID_DATA_SIZE (256)
-
-int gpio_xreg_get(uint8_t index, uint8_t *regValue)
+/* smifpkt_007a()    I2C Batch Request
+ *
+ * Up to I2C_BATCH_MAX_TXNS transactions on one segment in one round trip, for
+ * bulk EEPROM reads (a 1 KB DDR5 SPD is 32 reads of 32 bytes).  They run back
+ * to back in order; nothing else this daemon sends to that bus gets between
+ * them, since all I2C requests for a bus share one worker lane, picked with
+ * the bus when the request is queued.  Each transaction is the same as a
+ * 0x0072 one.
+ *
+ * Request:  segment, flags, count, then count x { address (8-bit), write_len,
+ *           read_len, write data }.
+ * Response: ErrorCode 0 or the code of the first failed transaction, the
+ *           limits, count, then count x { status (0 or I2C_* code), read_len,
+ *           read data }.  Failed transactions carry no data.  Processing
+ *           stops at the first failure unless I2C_BATCH_CONTINUE is set, and
+ *           with I2C_RESPONSE_LARGER_THAN_BUFFER when the next result would
+ *           not fit the response packet.
+ *
+ * flags I2C_BATCH_QUERY runs nothing and only returns the limits, for BIOS to
+ * detect support.
+ */
+int SmifPkt_007a(void *recv, void *resp)
 {
-    char temp[64];
-    unsigned long val;
-    int rv = 1;
-
-    if ((index != 1) && (index != 2)) {
-	    printf("Bad gpio index: %d\n", index);
-	    return rv;
+    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
+    Reply<struct pkt_807a> reply(recv, resp, 0x807a, SMIF_SERVICE_ID, offsetof(struct pkt_807a, result));
+    struct pkt_007a *recvMsg = (struct pkt_007a *)&recvPkt->msg[0];
+    struct pkt_807a *respMsg = reply.msg();
+    int len = (int)recvPkt->header.pkt_size - (int)sizeof(struct ChifPktHeader);
+    const uint8_t *txn, *end;
+    uint8_t *out;
+    int bus, i, rc;
+
+    respMsg->segment = recvMsg->segment;
+    respMsg->flags = recvMsg->flags;
+    respMsg->max_txns = I2C_BATCH_MAX_TXNS;
+    respMsg->max_len = I2C_XFER_MAX_LEN;
+    respMsg->max_data = CHIF_MSG_MAX_SIZE - offsetof(struct pkt_807a, result);
+    if (recvMsg->flags & I2C_BATCH_QUERY)
+        return reply.send();
+
+    dbPrintf("pkt_007a: segment 0x%02x, %d transactions\n", recvMsg->segment, recvMsg->count);
+    bus = request_bus(recvMsg->segment);
+    if (bus == -1) {
+        respMsg->ErrorCode = I2C_SEGMENT_DOES_NOT_EXIST;
+        return reply.send();
     }
 
-    FILE *fp = fopen("/sys/class/soc/xreg/server_id", "r");
-    if (fgets(temp, sizeof(temp), fp) != NULL) {
-        val = strtoul(temp, NULL, 16);
+    txn = recvMsg->txn;
+    end = &recvPkt->msg[len > (int)CHIF_MSG_MAX_SIZE ? (int)CHIF_MSG_MAX_SIZE : len];
+    for (i = 0; i < recvMsg->count; i++) {
+        uint8_t addr, wlen, rlen;
+
+        if (txn + 3 > end || txn + 3 + txn[1] > end) {
+            // transaction list runs past the packet
+            if (!respMsg->ErrorCode)
+                respMsg->ErrorCode = I2C_BAD_ARGUMENT;
+            break;
+        }
+        addr = txn[0] >> 1;
+        wlen = txn[1];
+        rlen = txn[2];
+        if (reply.room() < 2 + rlen) {
+            if (!respMsg->ErrorCode)
+                respMsg->ErrorCode = I2C_RESPONSE_LARGER_THAN_BUFFER;
+            break;
+        }
 
-        if (index == 1) {
-            val = val & 0xff;
-        } else if (index == 2) {
-            val = (val >> 8) & 0xff;
+        out = reply.tail();
+        if (wlen > I2C_XFER_MAX_LEN || rlen > I2C_XFER_MAX_LEN)
+            rc = I2C_SIZE_GREATER_THAN_MAX_STANDARD_TRANSACT_ERROR;
+        else
+            rc = smif_i2c_transaction(recvMsg->segment, bus, addr, &txn[3], wlen, &out[2], rlen);
+        txn += 3 + wlen;
+
+        out[0] = rc == I2C_SUCCESS ? 0 : rc;
+        out[1] = rc == I2C_SUCCESS ? rlen : 0;
+        reply.extend(2 + out[1]);
+        respMsg->count++;
+        if (rc != I2C_SUCCESS) {
+            if (!respMsg->ErrorCode)
+                respMsg->ErrorCode = rc;
+            if (!(recvMsg->flags & I2C_BATCH_CONTINUE))
+                break;
         }
-        *regValue = val;
-	rv = 0;
     }
-    fclose(fp);
-    return rv;
+
+    return reply.send();
+}
+
+int smif_i2c_bus(const void *recv)
+{
+    const struct ChifPkt *recvPkt = (const struct ChifPkt *)recv;
+    const struct pkt_0072 *recvMsg = (const struct pkt_0072 *)&recvPkt->msg[0];
+
+    if (recvPkt->header.service_id != SMIF_SERVICE_ID)
+        return -1;
+    if (recvPkt->header.command == 0x007a)
+        return select_bus(((const struct pkt_007a *)recvMsg)->segment);
+    if (recvPkt->header.command != 0x0072)
+        return -1;
+    if (recvMsg->address == 0xffff && recvMsg->segment == 0xff)
+        return -1;
+    return select_bus(recvMsg->segment);
 }
 
 /* 0088: "I/O bits access"  - contains payload
@@ -1123,77 +1179,76 @@ int gpio_xreg_get(uint8_t index, uint8_t *regValue)
 int SmifPkt_0088(void *recv, void *resp)
 {
     struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+    Reply<struct pkt_8088> reply(recv, resp, 0x8088);
     struct pkt_0088 *recvMsg = (struct pkt_0088 *)&recvPkt->msg[0];
-    struct pkt_8088 *respMsg = (struct pkt_8088 *)&respPkt->msg[0];
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8088);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8088;
-    respPkt->header.service_id = 0;
+    struct pkt_8088 *respMsg = reply.msg();
+    int rc = 0;
 
     respMsg->operation = recvMsg->operation;
     respMsg->index = recvMsg->index;
-    respMsg->status = 0; // we are optimistict everything goes well- FIXME
-
+    respMsg->status = SMIF_SUCCESS;
     respMsg->val = recvMsg->val;
+
+    dbPrintf("SMIF 0088: op %d index %08x val %02x\n", recvMsg->operation, recvMsg->index,
+             recvMsg->val);
     switch(recvMsg->operation){
        case SMIF_GET_MEMID:
-           dbPrintf("SMIF_GET_MEMID: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
+           rc = gpio_byte_get(GPIO_REGS_MEMID, recvMsg->index, &respMsg->val);
            break;
- 
+
        case SMIF_GET_GPI:
-           dbPrintf("SMIF_GET_GPI: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
+           rc = gpio_byte_get(GPIO_REGS_GPI, recvMsg->index, &respMsg->val);
            break;
- 
+
+       case SMIF_GET_GPO:
+           rc = gpio_byte_get(GPIO_REGS_GPO, recvMsg->index, &respMsg->val);
+           break;
+
+       case SMIF_PUT_GPO:
+           rc = gpio_byte_put(GPIO_REGS_GPO, recvMsg->index, recvMsg->val);
+           break;
+
        case SMIF_GET_CPLD:
-           dbPrintf("SMIF_GET_CPLD: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
            if (recvMsg->index > RANGE_CPLD) {
                printf("Index %d is out of range.\n", recvMsg->index);
-               respMsg->status = SMIF_BAD_INDEX;
+               rc = -ENOENT;
                break;
            }
-
-           if (gpio_xreg_get((uint8_t)recvMsg->index, &respMsg->val))
-               respMsg->status = SMIF_BAD;
-           else
-               respMsg->status = SMIF_SUCCESS;
+           rc = gpio_xreg_get((uint8_t)recvMsg->index, &respMsg->val);
            break;
- 
-       case SMIF_PUT_GPO:
-           dbPrintf("SMIF_PUT_GPO: index: %02x, val: %02x\n", recvMsg->index, recvMsg->val);
-           break;
- 
+
        case SMIF_PUT_CPLD:
-           dbPrintf("SMIF_PUT_CPLD: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
+           // the server ID is all there is and it is read-only; the write is
+           // dropped and acknowledged, as it always was
            break;
- 
+
        case SMIF_GET_GPIEN:
-           dbPrintf("SMIF_GET_GPIEN: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
-           break;
- 
        case SMIF_GET_GPIST:
-           dbPrintf("SMIF_GET_GPIST: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
+           rc = gpio_gpi_int_get(recvMsg->operation == SMIF_GET_GPIST, recvMsg->index,
+                                 &respMsg->val);
            break;
- 
+
        case SMIF_PUT_GPIEN:
-           dbPrintf("SMIF_PUT_GPIEN: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
-           break;
- 
        case SMIF_PUT_GPIST:
-           dbPrintf("SMIF_PUT_GPIST: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
-           break;
- 
-       case SMIF_GET_GPO:
-           dbPrintf("SMIF_GET_GPO: index: %08x, val: %02x\n", recvMsg->index, recvMsg->val);
+           rc = gpio_gpi_int_put(recvMsg->operation == SMIF_PUT_GPIST, recvMsg->index,
+                                 recvMsg->val);
            break;
- 
+
        default:
            printf("Invalid OP request\n");
            respMsg->status = SMIF_BAD_OP;
            break;
     }
-
-    return respPkt->header.pkt_size;
+    // a GPIO byte gpio.conf does not map (all of them without one) answers
+    // as before there were lines behind it: success, val echoed
+    if (rc == -ENOENT && recvMsg->operation != SMIF_GET_CPLD)
+        rc = 0;
+    if (rc == -ENOENT)
+        respMsg->status = SMIF_BAD_INDEX;
+    else if (rc < 0)
+        respMsg->status = SMIF_BAD;
+
+    return reply.send();
 }
 
 /*
@@ -1338,14 +1393,8 @@ bool findIpv6Addrs(struct ipv6Addr *ipv6Addrs)
  */
 int SmifPkt_0120(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_8120 *respMsg = (struct pkt_8120 *)&respPkt->msg[0];
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8120);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8120;
-    respPkt->header.service_id = 0;
+    Reply<struct pkt_8120> reply(recv, resp, 0x8120);
+    struct pkt_8120 *respMsg = reply.msg();
 
     /* go get the IPV6 information if present */
     if (findIpv6Addrs(respMsg->ipv6Addrs)) {
@@ -1366,7 +1415,7 @@ int SmifPkt_0120(void *recv, void *resp)
         respMsg->iLOIPPOST = 0; // display only ipv4.
     }
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 /*
@@ -1375,19 +1424,14 @@ int SmifPkt_0120(void *recv, void *resp)
 int SmifPkt_012b(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<struct pkt_812b> reply(recv, resp, 0x812b, SMIF_SERVICE_ID, offsetof(struct pkt_812b, buf));
 	struct pkt_012b *recvMsg = (struct pkt_012b *)&recvPkt->msg[0];
-	struct pkt_812b *respMsg = (struct pkt_812b *)&respPkt->msg[0];
+	struct pkt_812b *respMsg = reply.msg();
 
 	struct ev *local_ev;
 
 	dbPrintf("smif_012b: ev index: %d\n", recvMsg->idx);
 //	if ( recvMsg->idx == 198 ) system("sleep 60");
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_812b) - 4000;
-	dbPrintf("SizeOf Packet: %d\n", respPkt->header.pkt_size);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x812b;
-	respPkt->header.service_id = 0;
 
 	local_ev = getEVbyIndex(recvMsg->idx, (char *)respMsg->buf, EV_MAX_LEN);
 	if(EVError<0) {
@@ -1395,16 +1439,10 @@ int SmifPkt_012b(void *recv, void *resp)
 			case -1:
 				dbPrintf("No such EV");
 				respMsg->ErrorCode = 0x02; // Indicate EV not found.
-				for ( int i = 0 ; i < 32 ; i++ )
-					respMsg->name[i]='\0';
-				respMsg->sz_ev = 0;
-				for ( int i = 0 ; i < 4000 ; i++ )
-					respMsg->buf[i] = 0;
 				break;
 			default:
 				dbPrintf("Other Get EV by index error\n");
 				respMsg->ErrorCode = 0x01;
-				respMsg->sz_ev = 0;
 				break;
 		}
 	}
@@ -1420,9 +1458,10 @@ int SmifPkt_012b(void *recv, void *resp)
 		}
 		dbPrintf("Get EV by index Success! EV Name %s : Buffer %s Size %d\n", respMsg->name, respMsg->buf, local_ev->size);
 		respMsg->ErrorCode = 0x00;
-		respMsg->sz_ev += local_ev->size;
+		respMsg->sz_ev = local_ev->size;
+		reply.extend(respMsg->sz_ev);
 	}
-	return respPkt->header.pkt_size + respMsg->sz_ev;
+	return reply.send();
 }
 
 /*
@@ -1431,16 +1470,11 @@ int SmifPkt_012b(void *recv, void *resp)
 int SmifPkt_012c(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<struct pkt_812c> reply(recv, resp, 0x812c);
 	struct pkt_012c *recvMsg = (struct pkt_012c *)&recvPkt->msg[0];
-	struct pkt_812c *respMsg = (struct pkt_812c *)&respPkt->msg[0];
+	struct pkt_812c *respMsg = reply.msg();
 	int rc;
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_812c);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x812c;
-	respPkt->header.service_id = 0;
-
 	dbPrintf("\nsmif_012c: ev name: %s flags:%d sz_ev:%d\n", recvMsg->name, recvMsg->flags, recvMsg->sz_ev);
 
 	switch(recvMsg->flags) {
@@ -1501,20 +1535,14 @@ int SmifPkt_012c(void *recv, void *resp)
 			break;
 	}
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 /* SMIF callback for packet 0x012D - Get BIOS Image Authorization Status */
 int SmifPkt_012d(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-	struct pkt_812d *respMsg = (struct pkt_812d *)&respPkt->msg[0];
-
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_812d);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x812d;
-	respPkt->header.service_id = 0;
+	Reply<struct pkt_812d> reply(recv, resp, 0x812d);
+	struct pkt_812d *respMsg = reply.msg();
 
 	respMsg->ErrorCode = 0x0;
 	respMsg->ImageAuthStatusVersion = 1;
@@ -1524,7 +1552,7 @@ int SmifPkt_012d(void *recv, void *resp)
 	respMsg->CurrentStatusRemediationActionTaken = 0; // No action taken
 	respMsg->ValidatingAgent = 0; // BMC
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 /* 
@@ -1533,17 +1561,13 @@ int SmifPkt_012d(void *recv, void *resp)
 int SmifPkt_0130(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<struct pkt_8130> reply(recv, resp, 0x8130, SMIF_SERVICE_ID, offsetof(struct pkt_8130, buf));
 	struct pkt_0130 *recvMsg = (struct pkt_0130 *)&recvPkt->msg[0];
-	struct pkt_8130 *respMsg = (struct pkt_8130 *)&respPkt->msg[0];
+	struct pkt_8130 *respMsg = reply.msg();
 
 	int ev_size;
 
 	dbPrintf("\nsmif_0130: ev name: %s\n", recvMsg->name);
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8130) -1;
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8130;
-	respPkt->header.service_id = 0;
 
 	ev_size = getEVbyName((char *)recvMsg->name, (char *)respMsg->buf, EV_MAX_LEN);
 	if(ev_size<0) {
@@ -1560,11 +1584,12 @@ int SmifPkt_0130(void *recv, void *resp)
 	}
 	else {
 		respMsg->ErrorCode = 0x00; //return 0x00 as ok
-		respMsg->sz_ev += ev_size; //respMsg->sz_ev is 0 so now this is setting ev_size;
+		respMsg->sz_ev = ev_size;
 		memcpy(respMsg->name, recvMsg->name, sizeof(respMsg->name));
+		reply.extend(ev_size);
 	}
 
-	return respPkt->header.pkt_size + respMsg->sz_ev;
+	return reply.send();
 }
 
 /*
@@ -1572,21 +1597,15 @@ int SmifPkt_0130(void *recv, void *resp)
  */
 int SmifPkt_0132(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-	struct pkt_8132 *respMsg = (struct pkt_8132 *)&respPkt->msg[0];
-
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8132);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8132;
-	respPkt->header.service_id = 0;
+	Reply<struct pkt_8132> reply(recv, resp, 0x8132);
+	struct pkt_8132 *respMsg = reply.msg();
 
 	respMsg->ErrorCode = 0x00;
 	respMsg->max_sz = EV_FILE_MAX_SIZE / 1024;
 	respMsg->rem_sz = (EV_FILE_MAX_SIZE - EV_FILE_HEADER) - getSizeOfEVfile();
 	respMsg->present_evs = getNumOfAllEV();
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 /*
@@ -1594,19 +1613,13 @@ int SmifPkt_0132(void *recv, void *resp)
  */
 int SmifPkt_0133(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_8133 *respMsg = (struct pkt_8133 *)&respPkt->msg[0];
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8133);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8133;
-    respPkt->header.service_id = 0;
+    Reply<struct pkt_8133> reply(recv, resp, 0x8133);
+    struct pkt_8133 *respMsg = reply.msg();
 
     respMsg->ErrorCode = 0x00;
 	respMsg->state = 0x01;  // connected
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 /*
@@ -1614,16 +1627,11 @@ int SmifPkt_0133(void *recv, void *resp)
  */
 int SmifPkt_0136(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_8136 *respMsg = (struct pkt_8136 *)&respPkt->msg[0];
+    Reply<struct pkt_8136> reply(recv, resp, 0x8136);
+    struct pkt_8136 *respMsg = reply.msg();
 
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8136);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8136;
-    respPkt->header.service_id = 0;
 	respMsg->ErrorCode = 0x00;
-	return respPkt->header.pkt_size;
+	return reply.send();
 
 }
   
@@ -1632,14 +1640,8 @@ int SmifPkt_0136(void *recv, void *resp)
  */
 int SmifPkt_0139(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-	struct pkt_8139 *respMsg = (struct pkt_8139 *)&respPkt->msg[0];
-
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8139);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8139;
-	respPkt->header.service_id = 0;
+	Reply<struct pkt_8139> reply(recv, resp, 0x8139);
+	struct pkt_8139 *respMsg = reply.msg();
 
     // 1 = Factory,          2 = Wipe,       3 = Production,
     // 4 = High Security,    5 = FIPS,       6 = CNSA.
@@ -1648,7 +1650,7 @@ int SmifPkt_0139(void *recv, void *resp)
 
 	dbPrintf("smif_0139: error_code:0x%02x\n", respMsg->ErrorCode);
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 /*
@@ -1656,16 +1658,11 @@ int SmifPkt_0139(void *recv, void *resp)
  */
 int SmifPkt_013a(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_813a *respMsg = (struct pkt_813a *)&respPkt->msg[0];
+    Reply<struct pkt_813a> reply(recv, resp, 0x813a);
+    struct pkt_813a *respMsg = reply.msg();
 
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_813a);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x813a;
-    respPkt->header.service_id = 0;
 	respMsg->ErrorCode = 0;
-	return respPkt->header.pkt_size;
+	return reply.send();
 
 }
 
@@ -1675,20 +1672,19 @@ int SmifPkt_013a(void *recv, void *resp)
 int SmifPkt_0143(void *recv, void *resp)  
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<struct pkt_8143> reply(recv, resp, 0x8143);
 	struct pkt_0143 *recvMsg = (struct pkt_0143 *)&recvPkt->msg[0];
-	struct pkt_8143 *respMsg = (struct pkt_8143 *)&respPkt->msg[0];
+	struct pkt_8143 *respMsg = reply.msg();
 
 	dbPrintf("smif_0143: post_state:0x%02x\n", recvMsg->post_state);
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8143);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8143;
-	respPkt->header.service_id = 0;
-
-	respMsg->ErrorCode = 0x00;
+	// BIOS moves on, and may reset the host, with the EVs it set on flash
+	if (flushEV() < 0)
+		respMsg->ErrorCode = 0x01;	// EVs of the window not on flash
+	else
+		respMsg->ErrorCode = 0x00;
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 static constexpr char const* selMessageId = "b370836ccf2f4850ac5bee185b77893a";
@@ -1704,9 +1700,9 @@ extern void dbus_send(std::string message,
 int SmifPkt_0146(void *recv, void *resp)
 {
     struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+    Reply<struct pkt_8146> reply(recv, resp, 0x8146);
     struct pkt_0146 *recvMsg = (struct pkt_0146 *)&recvPkt->msg[0];
-    struct pkt_8146 *respMsg = (struct pkt_8146 *)&respPkt->msg[0];
+    struct pkt_8146 *respMsg = reply.msg();
     char buffer[512];
     char *event_message = buffer;
     char *event_severity;
@@ -1771,45 +1767,36 @@ int SmifPkt_0146(void *recv, void *resp)
     std::string message(event_message);
     std::replace(message.begin(), message.end(), ',', ';');
 
-    sd_journal_send("MESSAGE=%s", message.c_str(),
-                    "PRIORITY=%d", event_priority,
-                    "REDFISH_MESSAGE_ARGS=%s,%d,%d",
-                     message.c_str(), (uint32_t)recvMsg->evtClass, (uint32_t)recvMsg->evtCode,
-                    "NAME=EventAdd",
-                    "SEVERITY=%s", event_severity,
-                    "MESSAGE_ID=%s", selMessageId,
-                    "REDFISH_MESSAGE_ID=%s", event_ID, NULL);
-    dbus_send(message, recvMsg->evtClass, recvMsg->evtCode, recvMsg->evtType, "", recvMsg->severity);
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8146);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8146;
-    respPkt->header.service_id = 0;
+    if (!gChifOffline) {
+        sd_journal_send("MESSAGE=%s", message.c_str(),
+                        "PRIORITY=%d", event_priority,
+                        "REDFISH_MESSAGE_ARGS=%s,%d,%d",
+                         message.c_str(), (uint32_t)recvMsg->evtClass, (uint32_t)recvMsg->evtCode,
+                        "NAME=EventAdd",
+                        "SEVERITY=%s", event_severity,
+                        "MESSAGE_ID=%s", selMessageId,
+                        "REDFISH_MESSAGE_ID=%s", event_ID, NULL);
+        dbus_send(message, recvMsg->evtClass, recvMsg->evtCode, recvMsg->evtType, "", recvMsg->severity);
+    }
 
     respMsg->ErrorCode = 0x00;
     respMsg->evtType = recvMsg->evtType;
     respMsg->evtNum = 1234;   // FIXME, need to figure out how to get the event ID back from sd_journal_send.
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 /*
  * Pending SPD Clear Staus
  */
 int SmifPkt_0151(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_8151 *respMsg = (struct pkt_8151 *)&respPkt->msg[0];
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8151);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8151;
-    respPkt->header.service_id = 0;
+    Reply<struct pkt_8151> reply(recv, resp, 0x8151);
+    struct pkt_8151 *respMsg = reply.msg();
 
     respMsg->ErrorCode = 0;      // no errrors
     respMsg->pendingClear = 0;   // no pending clear
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 /* smifpkt_0153() Field Access
@@ -1822,19 +1809,12 @@ int SmifPkt_0151(void *recv, void *resp)
 int SmifPkt_0153(void *recv, void *resp)
 {
     struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+    Reply<struct pkt_8153> reply(recv, resp, 0x8153);
     struct pkt_0153 *recvMsg = (struct pkt_0153 *)&recvPkt->msg[0];
-    struct pkt_8153 *respMsg = (struct pkt_8153 *)&respPkt->msg[0];
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8153);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8153;
-    respPkt->header.service_id = 0;
+    struct pkt_8153 *respMsg = reply.msg();
 
     respMsg->operation = recvMsg->operation;
 	respMsg->ReturnCode = 0; // Success
-    for ( int i = 0 ; i < 256 ; i++ )
-        respMsg->buffer[i] = 0;
 
     if ( recvMsg->operation == 0x1 ) {
         // Read Serial Number
@@ -1850,7 +1830,7 @@ int SmifPkt_0153(void *recv, void *resp)
         respMsg->size = 0;
     }
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 /* smifpkt_0182()
@@ -1861,33 +1841,22 @@ int SmifPkt_0153(void *recv, void *resp)
  */
 int SmifPkt_0182(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_8182 *respMsg = (struct pkt_8182 *)&respPkt->msg[0];
-
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8182);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8182;
-    respPkt->header.service_id = 0;
+    Reply<struct pkt_8182> reply(recv, resp, 0x8182);
+    struct pkt_8182 *respMsg = reply.msg();
 
     respMsg->discoveryStatus = 1;  // discovery complete
     respMsg->tinkerStatus = 0;     // no tinker found
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 int SmifPkt_not_implemented(void *recv, void *resp, uint32_t rc)
 {
     struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_not_implemented *respMsg = (struct pkt_not_implemented *)&respPkt->msg[0];
+    Reply<struct pkt_not_implemented> reply(recv, resp, recvPkt->header.command | 0x8000);
 
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_not_implemented);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = recvPkt->header.command | 0x8000;
-    respPkt->header.service_id = 0;
-	respMsg->ErrorCode = rc;
-	return respPkt->header.pkt_size;
+	reply->ErrorCode = rc;
+	return reply.send();
 
 }
 
@@ -1912,15 +1881,10 @@ int SmifPkt_not_implemented(void *recv, void *resp, uint32_t rc)
 int SmifPkt_0200(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<struct pkt_8200> reply(recv, resp, 0x8200, SMIF_SERVICE_ID, offsetof(struct pkt_8200, data));
 	struct pkt_0200 *recvMsg = (struct pkt_0200 *)&recvPkt->msg[0];
-	struct pkt_8200 *respMsg = (struct pkt_8200 *)&respPkt->msg[0];
-
+	struct pkt_8200 *respMsg = reply.msg();
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8200);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8200;
-	respPkt->header.service_id = 0;
     respMsg->ErrorCode = 0x00;
 
     switch (recvMsg->op) {
@@ -1937,14 +1901,15 @@ int SmifPkt_0200(void *recv, void *resp)
                                                               (UINT32)recvMsg->timestamp,
                                                               (UINT16*)&rec_count,
                                                               (PlatDefDataRequest*)(recvMsg->data),
-                                                              (UINT8 *)&(respMsg->data),
-                                                              4000,
+                                                              reply.tail(),
+                                                              sizeof(respMsg->data),
                                                               (UINT32*)&token);
                 if ( respMsg->ErrorCode == PLATDEF_SMIF_RC_OK) {
                     dbPrintf("APML Platdef download specific data : Success\n");
                     respMsg->count = rec_count;
                     respMsg->data_size = resp_size;
                     respMsg->timestamp = token;
+                    reply.extend(resp_size);
                 } else {
                     dbPrintf("APML Platdef download specific data : Error-%d\n", respMsg->ErrorCode);
                 }
@@ -1965,7 +1930,7 @@ int SmifPkt_0200(void *recv, void *resp)
                                                               recType,
                                                               (PlatDefDataRequest*)(recvMsg->data),
                                                               (UINT32)rec_count,
-                                                              (UINT8 *)&(respMsg->data),
+                                                              reply.tail(),
                                                               (UINT16 *)&rec_count,
                                                               (UINT16 *)&resp_size,
                                                               (UINT32 *)&token);
@@ -1974,6 +1939,7 @@ int SmifPkt_0200(void *recv, void *resp)
                     respMsg->count = rec_count;
                     respMsg->data_size = resp_size;
                     respMsg->timestamp = token;
+                    reply.extend(respMsg->data_size);
                 } else {
                     dbPrintf("APML Platdef download specific data : Error-%d\n", respMsg->ErrorCode);
                 }
@@ -1982,12 +1948,15 @@ int SmifPkt_0200(void *recv, void *resp)
             break;
 
         default:
-            strncpy((char *)respMsg->data, (const char *)"No operation match", sizeof(respMsg->data));
+            strncpy((char *)reply.tail(), (const char *)"No operation match", sizeof(respMsg->data));
             dbPrintf("Unsupported 0x200 request: %x\n", recvMsg->op);
+            reply.extend(sizeof(respMsg->data));
             break;
     }
 
-	return respPkt->header.pkt_size;
+    // the host always reads the whole record area, unused records are zero
+	reply.pad(sizeof(struct pkt_8200));
+	return reply.send();
 }
 
 /**
@@ -1998,21 +1967,14 @@ int SmifPkt_0200(void *recv, void *resp)
  */
 int SmifPkt_0202(void *recv, void *resp)
 {
-    struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-    struct pkt_8202 *respMsg = (struct pkt_8202 *)&respPkt->msg[0];
+    Reply<struct pkt_8202> reply(recv, resp, 0x8202);
+    struct pkt_8202 *respMsg = reply.msg();
 	uint32_t count;
     /*Note: The maximum expected size of the request and response packet is 4096. This includes the chif header*/
     PlatDefTableData*  td;
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8202);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0x8202;
-	respPkt->header.service_id = 0;
     //respMsg->ErrorCode = 0x00;  don't think ErrorCode is used for this command.
 
-	memset(respMsg, 0, sizeof(pkt_8202));
-
     if (platdef_get_APML_data(&count, respMsg->Entities, (uint32_t)MAX_NUM_ENTITIES))
 	{
 		printf("Error in fetching the BIOS data\n");
@@ -2035,7 +1997,7 @@ int SmifPkt_0202(void *recv, void *resp)
 	    }
     }
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 typedef struct {
@@ -2069,16 +2031,11 @@ static bootProgressPolicy BootProgress;
 int SmifPkt_0209(void *recv, void *resp)
 {
     struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-    struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+    Reply<struct pkt_8209> reply(recv, resp, 0x8209);
     struct pkt_0209 *bootProgress = (struct pkt_0209 *)&recvPkt->msg[0];
-    struct pkt_8209 *respMsg = (struct pkt_8209 *)&respPkt->msg[0];
+    struct pkt_8209 *respMsg = reply.msg();
     bootProgressPolicy bootProg;
 
-    respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(struct pkt_8209);
-    respPkt->header.sequence = recvPkt->header.sequence;
-    respPkt->header.command = 0x8209;
-    respPkt->header.service_id = 0;
-
     memset(&bootProg, 0, sizeof(bootProgressPolicy));
     respMsg->ErrorCode = 0x00; //Assume Success
 
@@ -2097,211 +2054,81 @@ int SmifPkt_0209(void *recv, void *resp)
         dbPrintf("File write into NAND failure for BootProgress %d\n", bootProg.progressCode);
     }
 
-    return respPkt->header.pkt_size;
+    return reply.send();
 }
 
 int SmifPkt_badcmd(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<> reply(recv, resp, 0xffff);
 	uint32_t *pErrorCode = (uint32_t*)&recvPkt->msg[0];
 	uint8_t str_badcmd[] = "Bad command";
 
 	printf("Smif bad packet command 0x%04x\n", recvPkt->header.command);
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader) + sizeof(uint32_t) + sizeof(str_badcmd);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = 0xffff;
-	respPkt->header.service_id = 0;
+	reply.pad(sizeof(uint32_t) + sizeof(str_badcmd));
 
 	*pErrorCode = 0xffff0000;
 
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
-int SmifHandler(void *recv, void *resp)
+static int SmifPkt_not_implemented_rc0(void *recv, void *resp)
 {
-	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-//	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
-
-    dbPrintf("Command: %04x\n", recvPkt->header.command);
-
-	switch(recvPkt->header.command) {
-		case 0x0002:
-			dbPrintf("smif_0x0002: Get Status\n");
-			return SmifPkt_0002(recv, resp);
-
-        case 0x0006:
-            dbPrintf("smif_0x0006: Get Network Info\n");
-            return smifpkt_0006(recv, resp);
-
-        case 0x0008:
-            dbPrintf("smif_0x0008: Set ICRU ready\n");
-            return SmifPkt_0008(recv, resp);
-
-        case 0x0035:
-            dbPrintf("smif_0x0035: Set PCI Device Info\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0050:
-            dbPrintf("smif_0x0050: Flash Command\n");
-            return SmifPkt_0050(recv, resp);
-
-        case 0x0055:
-            dbPrintf("smif_0x0055: Get IOP Date and Time\n");
-            return SmifPkt_0055(recv, resp);
-
-        case 0x0056:
-            dbPrintf("smif_0x0056: Set IOP Date and Time\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-		case 0x0063:
-			dbPrintf("smif_0x0063: Get NIC Config\n");
-			return SmifPkt_0063(recv, resp);
-
-        case 0x06e:
-            dbPrintf("smif_0x006e: Get License\n");
-            return SmifPkt_006e(recv, resp);
-
-		case 0x0072:
-			dbPrintf("smif_0x0072: I2C Transaction Request\n");
-			return SmifPkt_0072(recv, resp);
-
-        case 0x0076:
-            dbPrintf("smif_0x0076: Option ROM milestone\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-		case 0x0088:
-            dbPrintf("smif_0x0088: I/O bit access\n");
-            return SmifPkt_0088(recv, resp);
-
-		case 0x011c:
-            dbPrintf("smif_0x011c: RIS Blob store\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-		case 0x0120:
-            dbPrintf("smif_0x0120: Get IPv6 status\n");
-            return SmifPkt_0120(recv, resp);
-
-		case 0x012b:
-			dbPrintf("smif_0x012B: Get Status BY EV index\n");
-			return SmifPkt_012b(recv, resp);
-
-		case 0x012c:
-			dbPrintf("smif_0x012C: EV Set/Delete/Delete All\n");
-			return SmifPkt_012c(recv, resp);
-
-		case 0x012d:
-			dbPrintf("smif_0x012D: Get BIOS Authorization Status\n");
-			return SmifPkt_012d(recv, resp);
-
-		case 0x0130:
-			dbPrintf("smif_0x0130: Get EV by name\n");
-			return SmifPkt_0130(recv, resp);
-
-		case 0x0132:
-			dbPrintf("smif_0x0132: Get EV file sys status\n");
-			return SmifPkt_0132(recv, resp);
-
-		case 0x0133:
-            dbPrintf("smif_0x0133: Get Virtual UART state \n");
-            return SmifPkt_0133(recv, resp);
-
-		case 0x0136:
-            dbPrintf("smif_0x0136: BIOS Sync response \n");
-            return SmifPkt_0136(recv, resp);
-
-		case 0x0139:
-			dbPrintf("smif_0x0139: Get security state response\n");
-			return SmifPkt_0139(recv, resp);
-
-        case 0x013a:
-            dbPrintf("smif_0x013A: Entropy from BIOS\n");
-            return SmifPkt_013a(recv, resp);
-
-		case 0x0143:
-			dbPrintf("smif_0x0143: BIOS POST State response\n");
-			return SmifPkt_0143(recv, resp);
-
-        case 0x0146:
-            dbPrintf("smif_0x0146: Quick Event Add\n");
-            return SmifPkt_0146(recv, resp);
-
-		case 0x0150:
-			dbPrintf("smif_0x0150: Reponse Read CPLD Shutdown & Power Fault\n");
-			return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0151:
-            dbPrintf("smif_0x0151: SPD Clear Status Request\n");
-            return SmifPkt_0151(recv, resp);
-
-        case 0x0153:
-            dbPrintf("smif_0x0153: Field Access Request\n");
-            return SmifPkt_0153(recv, resp);
-
-        case 0x0155:
-            dbPrintf("smif_0x0155: Field Access Request\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0158:
-            dbPrintf("smif_0x0158: Send BIOS Security States\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0159:
-            dbPrintf("smif_0x0159: Get Host Interface information Request\n");
-			return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0161:
-            dbPrintf("smif_0x0161: BIOS Features\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0173:
-            dbPrintf("smif_0x0173: send (receive) private data\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0174:
-            dbPrintf("smif_0x0174: REST Task Command Response\n");
-            return SmifPkt_not_implemented(recv, resp, 5);
-
-        case 0x0176:
-            dbPrintf("smif_0x0176: Set Power Regulator Configuration Data\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0177:
-            dbPrintf("smif_0x0177: Set Power Regulator Mode\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0178:
-            dbPrintf("smif_0x0178: Get Device SPDM Status\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0179:
-            dbPrintf("smif_0x0179: BIOS sends SPD bytes\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0182:
-            dbPrintf("smif_0x0182: Tinker discovery status\n");
-            return SmifPkt_0182(recv, resp);
-
-        case 0x0200:
-            dbPrintf("smif_0x0200: Platform APML IO Handler\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
-
-        case 0x0202:
-            dbPrintf("smif_0x0202: Fetch and send APML records\n");
-            return SmifPkt_0202(recv, resp);
-
-        case 0x0204:
-            dbPrintf("smif_0x0204: Receive measurement info from BIOS\n");
-            return SmifPkt_not_implemented(recv, resp, 0);
+	return SmifPkt_not_implemented(recv, resp, 0);
+}
 
-        case 0x0209:
-            dbPrintf("smif_0x0209: Get BootProgress Policy from BIOS\n");
-            return SmifPkt_0209(recv, resp);
+static int SmifPkt_not_implemented_rc5(void *recv, void *resp)
+{
+	return SmifPkt_not_implemented(recv, resp, 5);
+}
 
-		default:
-			break;
-	}
+/* SMIF command registrations: command, request bytes read, response, flags, handler, name */
+static constexpr struct chif_cmd smif_cmds[] = {
+	CHIF_CMD(0x0002, 0, struct pkt_8002, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0002, "Get Status"),
+	CHIF_CMD(0x0006, 0, struct pkt_8006, CHIF_CMD_IDEMPOTENT, smifpkt_0006, "Get Network Info"),
+	CHIF_CMD(0x0008, 0, struct pkt_8008, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0008, "Set ICRU ready"),
+	CHIF_CMD(0x0035, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Set PCI Device Info"),
+	CHIF_CMD(0x0050, 0, struct pkt_8050, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0050, "Flash Command"),
+	CHIF_CMD(0x0055, 0, struct pkt_8055, CHIF_CMD_IDEMPOTENT, SmifPkt_0055, "Get IOP Date and Time"),
+	CHIF_CMD(0x0056, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Set IOP Date and Time"),
+	CHIF_CMD(0x0063, 0, struct pkt_8063, CHIF_CMD_IDEMPOTENT, SmifPkt_0063, "Get NIC Config"),
+	CHIF_CMD(0x006e, 0, struct pkt_806e, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_006e, "Get License"),
+	CHIF_CMD(0x0072, sizeof(struct pkt_0072), struct pkt_8072, CHIF_CMD_OFFLOAD, SmifPkt_0072, "I2C Transaction Request"),
+	CHIF_CMD(0x0076, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Option ROM milestone"),
+	CHIF_CMD(0x007a, offsetof(struct pkt_007a, txn), struct pkt_807a, CHIF_CMD_OFFLOAD, SmifPkt_007a, "I2C Batch Request"),
+	CHIF_CMD(0x0088, sizeof(struct pkt_0088), struct pkt_8088, 0, SmifPkt_0088, "I/O bit access"),
+	CHIF_CMD(0x011c, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "RIS Blob store"),
+	CHIF_CMD(0x0120, 0, struct pkt_8120, CHIF_CMD_IDEMPOTENT, SmifPkt_0120, "Get IPv6 status"),
+	CHIF_CMD(0x012b, sizeof(struct pkt_012b), struct pkt_812b, CHIF_CMD_IDEMPOTENT, SmifPkt_012b, "Get Status BY EV index"),
+	CHIF_CMD(0x012c, offsetof(struct pkt_012c, buf), struct pkt_812c, 0, SmifPkt_012c, "EV Set/Delete/Delete All"),
+	CHIF_CMD(0x012d, 0, struct pkt_812d, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_012d, "Get BIOS Authorization Status"),
+	CHIF_CMD(0x0130, sizeof(struct pkt_0130), struct pkt_8130, CHIF_CMD_IDEMPOTENT, SmifPkt_0130, "Get EV by name"),
+	CHIF_CMD(0x0132, 0, struct pkt_8132, CHIF_CMD_IDEMPOTENT, SmifPkt_0132, "Get EV file sys status"),
+	CHIF_CMD(0x0133, 0, struct pkt_8133, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0133, "Get Virtual UART state"),
+	CHIF_CMD(0x0136, 0, struct pkt_8136, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0136, "BIOS Sync response"),
+	CHIF_CMD(0x0139, 0, struct pkt_8139, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0139, "Get security state response"),
+	CHIF_CMD(0x013a, 0, struct pkt_813a, CHIF_CMD_IDEMPOTENT, SmifPkt_013a, "Entropy from BIOS"),
+	CHIF_CMD(0x0143, sizeof(struct pkt_0143), struct pkt_8143, 0, SmifPkt_0143, "BIOS POST State response"),
+	CHIF_CMD(0x0146, offsetof(struct pkt_0146, buf), struct pkt_8146, CHIF_CMD_OFFLOAD, SmifPkt_0146, "Quick Event Add"),
+	CHIF_CMD(0x0150, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Reponse Read CPLD Shutdown & Power Fault"),
+	CHIF_CMD(0x0151, 0, struct pkt_8151, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0151, "SPD Clear Status Request"),
+	CHIF_CMD(0x0153, offsetof(struct pkt_0153, buffer), struct pkt_8153, CHIF_CMD_IDEMPOTENT, SmifPkt_0153, "Field Access Request"),
+	CHIF_CMD(0x0155, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Field Access Request"),
+	CHIF_CMD(0x0158, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Send BIOS Security States"),
+	CHIF_CMD(0x0159, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Get Host Interface information Request"),
+	CHIF_CMD(0x0161, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "BIOS Features"),
+	CHIF_CMD(0x0173, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "send (receive) private data"),
+	CHIF_CMD(0x0174, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc5, "REST Task Command Response"),
+	CHIF_CMD(0x0176, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Set Power Regulator Configuration Data"),
+	CHIF_CMD(0x0177, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Set Power Regulator Mode"),
+	CHIF_CMD(0x0178, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Get Device SPDM Status"),
+	CHIF_CMD(0x0179, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "BIOS sends SPD bytes"),
+	CHIF_CMD(0x0182, 0, struct pkt_8182, CHIF_CMD_IDEMPOTENT|CHIF_CMD_CACHEABLE, SmifPkt_0182, "Tinker discovery status"),
+	CHIF_CMD(0x0200, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Platform APML IO Handler"),
+	CHIF_CMD(0x0202, 0, struct pkt_8202, CHIF_CMD_IDEMPOTENT, SmifPkt_0202, "Fetch and send APML records"),
+	CHIF_CMD(0x0204, 0, struct pkt_not_implemented, CHIF_CMD_IDEMPOTENT, SmifPkt_not_implemented_rc0, "Receive measurement info from BIOS"),
+	CHIF_CMD(0x0209, sizeof(struct pkt_0209), struct pkt_8209, 0, SmifPkt_0209, "Get BootProgress Policy from BIOS"),
+};
 
-	return SmifPkt_badcmd(recv, resp);
-}
+CHIF_SERVICE(smif_service, SMIF_SERVICE_ID, "smif", chif_key_command, smif_cmds, SmifPkt_badcmd);
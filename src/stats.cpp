@@ -0,0 +1,228 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "i2c_cache.hpp"
+#include "i2c_health.hpp"
+#include "i2c_stats.hpp"
+#include "stats.hpp"
+
+#define CHIF_STATS_SLOTS    128     // power of 2, well above the registered commands
+
+struct chif_cmd_stats {
+    bool used;
+    uint8_t service_id;
+    uint16_t command;
+    const char *name;
+    uint64_t count;
+    uint64_t errors;            // handler produced no response
+    uint64_t write_errors;
+    struct lat_hist handler;
+    struct lat_hist write;
+};
+
+/* only touched from the event loop, so no locking */
+static struct chif_cmd_stats cmd_stats[CHIF_STATS_SLOTS];
+static struct chif_cmd_stats overflow_stats;
+static uint64_t stats_since_ns;
+
+uint64_t stats_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void lat_hist_add(struct lat_hist *h, uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    int b = us ? 64 - __builtin_clzll(us) : 0;
+
+    if (b >= LAT_HIST_BUCKETS)
+        b = LAT_HIST_BUCKETS - 1;
+
+    h->bucket[b]++;
+    h->count++;
+    h->sum_ns += ns;
+    if (ns > h->max_ns)
+        h->max_ns = ns;
+}
+
+void lat_hist_merge(struct lat_hist *h, const struct lat_hist *src)
+{
+    int b;
+
+    for (b = 0; b < LAT_HIST_BUCKETS; b++)
+        h->bucket[b] += src->bucket[b];
+    h->count += src->count;
+    h->sum_ns += src->sum_ns;
+    if (src->max_ns > h->max_ns)
+        h->max_ns = src->max_ns;
+}
+
+uint64_t lat_hist_percentile(const struct lat_hist *h, double pct)
+{
+    uint64_t want, seen = 0;
+    int b;
+
+    if (!h->count)
+        return 0;
+
+    want = (uint64_t)(h->count * pct / 100.0);
+    if (want >= h->count)
+        want = h->count - 1;
+
+    for (b = 0; b < LAT_HIST_BUCKETS; b++) {
+        seen += h->bucket[b];
+        if (seen > want)
+            break;
+    }
+    return 1ull << b;
+}
+
+void lat_hist_print(FILE *fp, const char *label, const struct lat_hist *h)
+{
+    int b;
+
+    if (!h->count)
+        return;
+
+    fprintf(fp, "    %-8s n=%llu avg=%lluus p50<%lluus p99<%lluus max=%lluus\n", label,
+            (unsigned long long)h->count,
+            (unsigned long long)(h->sum_ns / h->count / 1000),
+            (unsigned long long)lat_hist_percentile(h, 50),
+            (unsigned long long)lat_hist_percentile(h, 99),
+            (unsigned long long)(h->max_ns / 1000));
+
+    fprintf(fp, "            ");
+    for (b = 0; b < LAT_HIST_BUCKETS; b++) {
+        if (h->bucket[b])
+            fprintf(fp, " <%lluus:%llu", 1ull << b, (unsigned long long)h->bucket[b]);
+    }
+    fprintf(fp, "\n");
+}
+
+static struct chif_cmd_stats *chif_stats_slot(uint8_t service_id, uint16_t command)
+{
+    uint32_t key = ((uint32_t)service_id << 16) | command;
+    uint32_t i, slot;
+
+    for (i = 0; i < CHIF_STATS_SLOTS; i++) {
+        slot = (key * 2654435761u + i) & (CHIF_STATS_SLOTS - 1);
+        if (!cmd_stats[slot].used) {
+            cmd_stats[slot].used = true;
+            cmd_stats[slot].service_id = service_id;
+            cmd_stats[slot].command = command;
+            return &cmd_stats[slot];
+        }
+        if (cmd_stats[slot].service_id == service_id && cmd_stats[slot].command == command)
+            return &cmd_stats[slot];
+    }
+
+    // table full of garbage commands, account the rest together
+    return &overflow_stats;
+}
+
+void chif_stats_record(const struct ChifPkt *req, int out_size, uint64_t handler_ns,
+                       int write_rc, uint64_t write_ns)
+{
+    struct chif_cmd_stats *st;
+    const struct chif_cmd *cmd;
+
+    if (!stats_since_ns)
+        stats_since_ns = stats_now_ns();
+
+    // registered commands are keyed like the dispatcher (health uses msg[0])
+    cmd = chif_lookup(req);
+    st = chif_stats_slot(req->header.service_id, cmd ? cmd->command : req->header.command);
+    if (!st->name)
+        st->name = cmd ? cmd->name : "unregistered";
+
+    st->count++;
+    lat_hist_add(&st->handler, handler_ns);
+    if (out_size <= 0) {
+        st->errors++;
+        return;
+    }
+
+    lat_hist_add(&st->write, write_ns);
+    if (write_rc < 0)
+        st->write_errors++;
+}
+
+static void chif_stats_print(FILE *fp, const struct chif_cmd_stats *st, double secs)
+{
+    fprintf(fp, "  svc 0x%02x cmd 0x%04x %-40s count=%llu (%.1f/s) errors=%llu write_errors=%llu\n",
+            st->service_id, st->command, st->name,
+            (unsigned long long)st->count, secs > 0 ? st->count / secs : 0.0,
+            (unsigned long long)st->errors, (unsigned long long)st->write_errors);
+    lat_hist_print(fp, "handler", &st->handler);
+    lat_hist_print(fp, "write", &st->write);
+}
+
+void chif_stats_dump(FILE *fp)
+{
+    double secs = 0;
+    int i;
+
+    if (stats_since_ns)
+        secs = (stats_now_ns() - stats_since_ns) / 1e9;
+
+    fprintf(fp, "CHIF command statistics, %.1f s since first request or reset\n", secs);
+    for (i = 0; i < CHIF_STATS_SLOTS; i++) {
+        if (cmd_stats[i].used)
+            chif_stats_print(fp, &cmd_stats[i], secs);
+    }
+    if (overflow_stats.count) {
+        overflow_stats.name = "other";
+        chif_stats_print(fp, &overflow_stats, secs);
+    }
+    fflush(fp);
+}
+
+void chif_stats_reset(void)
+{
+    memset(cmd_stats, 0, sizeof(cmd_stats));
+    memset(&overflow_stats, 0, sizeof(overflow_stats));
+    stats_since_ns = 0;
+}
+
+void chif_stats_signal(int signo, int value, void *ctx)
+{
+    (void)signo;
+    (void)ctx;
+
+    chif_stats_dump(stdout);
+    i2c_cache_stats(stdout, value == 1);
+    i2c_stats_dump(stdout);
+    i2c_health_dump(stdout);
+    if (value == 1) {
+        i2c_stats_reset();
+        i2c_health_reset();
+        chif_stats_reset();
+        printf("CHIF command statistics reset\n");
+    }
+}
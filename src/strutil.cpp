@@ -71,6 +71,37 @@ int strutil_icmp(const char* str1, const char* str2)
     return(char1 - char2);
 }
 
+/* hexdump_line()
+ *
+ * Format up to 16 bytes as "xx xx ...  ascii" at out, hex column padded to
+ * 16 bytes.  Returns the length written (out needs HEXDUMP_LINE bytes).
+ */
+#define HEXDUMP_LINE    (16 * 3 + 2 + 16 + 1)
+
+static int hexdump_line(char *out, const unsigned char *d, int n)
+{
+    static const char hex[] = "0123456789abcdef";
+    char *o = out;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        if (i < n) {
+            *o++ = hex[d[i] >> 4];
+            *o++ = hex[d[i] & 0xf];
+        } else {
+            *o++ = ' ';
+            *o++ = ' ';
+        }
+        *o++ = ' ';
+    }
+    *o++ = ' ';
+    *o++ = ' ';
+    for (i = 0; i < n; i++)
+        *o++ = (d[i] > 31 && d[i] < 127) ? d[i] : '.';
+    *o = 0;
+    return o - out;
+}
+
 /* hexdump_b()
  *
  * byte hex dumper with ASCII decode.  This can be called from other routines
@@ -78,34 +109,21 @@ int strutil_icmp(const char* str1, const char* str2)
  */
 int hexdump_b(void *p, int len)
 {
-    unsigned char data, *d;
-    unsigned char pbuf[17];
+    unsigned char *d;
+    char line[HEXDUMP_LINE];
     int i;
 
     if ((p==NULL) || (len==0))
         return(-1);
 
+    // formatting is the expensive part, skip it when nothing is printed
+    if (!gdbPrint)
+        return(0);
 
     d = (unsigned char*)p;
-    for ( i=0; i<len; i++, d++ ) {
-        if ( i % 16 == 0 )  {
-            if ( i ) {
-                dbPrintf("  %s\r\n%p  ", pbuf, d);
-            } else {
-                dbPrintf("%p  ", d);
-            }
-            memset (pbuf, 0, sizeof(pbuf));
-        }
-        data = *d;
-
-        dbPrintf("%02x ", data);
-        pbuf[i % 16] = (data>31 && data<127) ? data : '.';
-    }
-
-    if ( i % 16 ) {
-        dbPrintf ("  %*c%s\r\n", 3 * (16 - (i % 16)), ' ', pbuf);
-    } else {
-        dbPrintf("  %s\r\n", pbuf);
+    for ( i=0; i<len; i+=16 ) {
+        hexdump_line(line, &d[i], len - i < 16 ? len - i : 16);
+        dbPrintf("%p  %s\r\n", &d[i], line);
     }
     return(0);
 }
@@ -120,9 +138,7 @@ int hexdump_b(void *p, int len)
  */
 int hexdump_b_hind(void *p, int len, char *indent_lbl)
 {
-    unsigned char data, *d;
-    char pbuf[17];
-    char chunk[8];
+    unsigned char *d;
     char line[160];
     size_t szlbl;
     int i;
@@ -130,40 +146,22 @@ int hexdump_b_hind(void *p, int len, char *indent_lbl)
     if ((p==NULL) || (len==0))
         return(-1);
 
+    if (!gdbPrint)
+        return(0);
+
     if (!indent_lbl) indent_lbl=(char*)"";
-    //FIXME: if there is desire to remove this str len, hexdump_b_hind called by at least 8 other source files. 
     szlbl = strlen(indent_lbl);
+    if (szlbl > sizeof(line) - HEXDUMP_LINE)
+        szlbl = sizeof(line) - HEXDUMP_LINE;
 
+    // label on the first line, the same width of blanks on the others
+    memcpy(line, indent_lbl, szlbl);
     d = (unsigned char*)p;
-    for ( i=0; i<len; i++, d++ ) {
-        if ( i % 16 == 0 )  {
-            if ( i ) {
-                dbPrintf("%s  %s\r\n", line, pbuf);
-            }
-            if (i == 0) {
-               snprintf(line, sizeof(line)-1, (char*)"%s", indent_lbl);
-            } else {
-               memset(line, ' ', sizeof(line));
-               line[szlbl]=0;
-            }
-            memset (pbuf, 0, sizeof(pbuf));
-        }
-
-        data = *d;
-        snprintf( chunk, sizeof(chunk), (char*)"%02x ", data);
-        strncat(line, chunk, sizeof(line)-strlen(line)-1);
-        pbuf[i % 16] = (data>31 && data<127) ? data : '.';
+    for ( i=0; i<len; i+=16 ) {
+        hexdump_line(&line[szlbl], &d[i], len - i < 16 ? len - i : 16);
+        dbPrintf("%s\r\n", line);
+        memset(line, ' ', szlbl);
     }
-
-    if ( i % 16 ) {
-        // remainder - pad line with spaces then concatenate pbuf
-        // printf ("  %*c%s\r\n", 3 * (16 - (i % 16)), ' ', pbuf);
-        for (len=0; len< (16 - (i % 16)); len++) {
-	   strncat(line, "   ", sizeof(line)-strlen(line)-1);
-        }
-    }
-
-    dbPrintf("%s  %s\r\n", line, pbuf);
     return(0);
 }
 
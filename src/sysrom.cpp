@@ -36,10 +36,12 @@
 #include "smif.hpp"
 #include "smbios.hpp"
 #include "misc.hpp"
+#include "chif_dispatch.hpp"
+#include "chif_reply.hpp"
+#include "i2c_cache.hpp"
 
 char const *mdrV2Service = "xyz.openbmc_project.Smbios.MDR_V2";
 char const *mdrV2Interface = "xyz.openbmc_project.Smbios.MDR_V2";
-char const *smbios_path = "/var/lib/smbios/smbios2";
 char const* mdrV2Path = "/xyz/openbmc_project/Smbios/MDR_V2";
 uint8_t mdrTypeII = 2;
 uint8_t dirVer = 1;
@@ -47,73 +49,79 @@ uint8_t dirVer = 1;
 int Rom_Response(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<> reply(recv, resp, recvPkt->header.command, ROM_SERVICE_ID);
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = recvPkt->header.command;
-	respPkt->header.service_id = ROM_SERVICE_ID;
-
-	return respPkt->header.pkt_size;
+	return reply.send();
 }
 
 
-int RomHandler(void *recv, void *resp, int resp_len)
+#define SMBIOS_PATH      CHIF_PATH("/var/lib/smbios/smbios2")
+#define SMBIOS_TEMP_PATH CHIF_PATH("/var/lib/smbios/smbios_temp")
+
+/* 0x03: SMBIOS Begin Command */
+static int Rom_SmbiosBegin(void *recv, void *resp)
+{
+	if (WriteSmbiosRecords((char *)SMBIOS_TEMP_PATH, 0, -1))
+	{
+		return Rom_Response(recv, resp);
+	}
+	return -1;
+}
+
+/* 0x04 / 0x0c: one SMBIOS record or a blob of records */
+static int Rom_SmbiosRecords(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	char const *temp_path = "/var/lib/smbios/smbios_temp";
 
-	memset(resp, 0, resp_len);
-	dbPrintf("RomHandler: command:0x%08x\n", recvPkt->header.command);
+	if (WriteSmbiosRecords((char *)SMBIOS_TEMP_PATH, (char *)recvPkt->msg, recvPkt->header.pkt_size))
+	{
+		return Rom_Response(recv, resp);
+	}
+	return -1;
+}
 
-	switch(recvPkt->header.command) {
-		case 0x03:	//SMBIOS Begin Command
-			dbPrintf("Begin receiving SMBIOS records\n");
-			if (WriteSmbiosRecords((char *)temp_path, 0, -1))
-			{
-				return Rom_Response(recv, resp);
-			}
-			return -1;
+/* 0x05: SMBIOS END */
+static int Rom_SmbiosEnd(void *recv, void *resp)
+{
+	if (WriteSmbiosRecords((char *)SMBIOS_TEMP_PATH, 0, -2))
+	{
+		// the DIMMs may have changed, so may the SPDs worth caching
+		i2c_cache_policy_smbios();
 
-		case 0x04:	//new SMBIOS Record
-			dbPrintf("Receiving single SMBIOS record\n");
-			if (WriteSmbiosRecords((char *)temp_path, (char *)recvPkt->msg, recvPkt->header.pkt_size))
-			{
-				return Rom_Response(recv, resp);
+		// FIXUP - handle errors
+		if (gChifOffline) {
+			// no service to restart
+		} else if (system("systemctl stop smbios-mdrv2.service") == 0) {
+			if (system("systemctl start smbios-mdrv2.service") != 0) {
+				printf("Could not start smbios-mdrv2 service\n");
 			}
-			return -1;
-		case 0x05:	//SMBIOS END
-			if (WriteSmbiosRecords((char *)temp_path, 0, -2))
-			{
-				// FIXUP - handle errors
-				if (system("systemctl stop smbios-mdrv2.service") == 0) {
-					if (system("systemctl start smbios-mdrv2.service") != 0) {
-						printf("Could not start smbios-mdrv2 service\n");
-					}
-				} else {
-						printf("Could not stop smbios-mdrv2 service\n");
-					}
-				return Rom_Response(recv, resp);
-			}
-			return -1;
-		case 0x06:
-			return Rom_Response(recv, resp);
-		case 0x07:
-			return Rom_Response(recv, resp);
-		case 0x0c:	//new SMBIOS Record blob
-			dbPrintf("Receiving multiple SMBIOS records\n");
-			if (WriteSmbiosRecords((char *)temp_path, (char *)recvPkt->msg, recvPkt->header.pkt_size))
-			{
-				return Rom_Response(recv, resp);
-			}
-			return -1;
-			break;
-		default:
-			//other rom command doesn't need to response
-			return -1;
+		} else {
+			printf("Could not stop smbios-mdrv2 service\n");
+		}
+		return Rom_Response(recv, resp);
 	}
+	return -1;
 }
 
+/* other rom commands don't need a response */
+static int Rom_NoResponse(void *recv, void *resp)
+{
+	(void)recv;
+	(void)resp;
+	return -1;
+}
+
+static constexpr struct chif_cmd rom_cmds[] = {
+	CHIF_CMD(0x03, 0, void, 0, Rom_SmbiosBegin, "Begin receiving SMBIOS records"),
+	CHIF_CMD(0x04, 0, void, 0, Rom_SmbiosRecords, "Receiving single SMBIOS record"),
+	CHIF_CMD(0x05, 0, void, CHIF_CMD_OFFLOAD, Rom_SmbiosEnd, "End of SMBIOS records"),
+	CHIF_CMD(0x06, 0, void, CHIF_CMD_IDEMPOTENT, Rom_Response, "ROM Acknowledge"),
+	CHIF_CMD(0x07, 0, void, CHIF_CMD_IDEMPOTENT, Rom_Response, "ROM Acknowledge"),
+	CHIF_CMD(0x0c, 0, void, 0, Rom_SmbiosRecords, "Receiving multiple SMBIOS records"),
+};
+
+CHIF_SERVICE(rom_service, ROM_SERVICE_ID, "rom", chif_key_command, rom_cmds, Rom_NoResponse);
+
 static uint8_t calculateChecksum(uint8_t *data, int len) {
     int i;
     uint16_t sum=0;
@@ -185,34 +193,59 @@ int WriteSmbiosRecords(char path[], char *buffer, int size)
             fclose(fptr);
             dbPrintf("checking if smbios file exists.\n");
             struct stat finfo;
-            if (stat(smbios_path, &finfo) == 0) {             // if smbios file already exists
-                if (remove(smbios_path) ==0) {
+            if (stat(SMBIOS_PATH, &finfo) == 0) {             // if smbios file already exists
+                if (remove(SMBIOS_PATH) ==0) {
                     dbPrintf("Removed old SMBIOS file.\n");
                 } else {
-                    dbPrintf("Error removing old SMBIOS file %s\n", smbios_path);
+                    dbPrintf("Error removing old SMBIOS file %s\n", SMBIOS_PATH);
                     perror("Error removing old SMBIOS file");
                     return -1;
                 }
             } else {
                 dbPrintf("No SMBIOS file to remove.\n");
             }
-            if (rename(path, smbios_path) == 0) {
+            if (rename(path, SMBIOS_PATH) == 0) {
                 dbPrintf("SMBIOS-MDR file successfully replaced.\n");
-                syncSmbiosData();
+                if (!gChifOffline)
+                    syncSmbiosData();
             } else {
                 perror("SMBIOS: Error renaming SMBIOS file");
-                dbPrintf("Failed to copy SMBIOS Records file. Exists at:\n\t%s\nBut was not copied to the proper location:\n\t%s\n", path, smbios_path);
+                dbPrintf("Failed to copy SMBIOS Records file. Exists at:\n\t%s\nBut was not copied to the proper location:\n\t%s\n", path, SMBIOS_PATH);
                 return -1;
             }
         } else { //Write buffer into smbios records file
-            uint32_t NumRecs = (uint32_t)buffer[0];
-            dbPrintf("Number of Records = %d\n", NumRecs);
+            const uint8_t *p = (const uint8_t *)buffer;
+            uint32_t NumRecs, end;
             uint16_t RecSz;
             uint32_t i = sizeof(uint32_t);
+
+            // size is the pkt_size the host put in the header: keep it within
+            // the receive buffer, and long enough for the record count
+            if (size > CHIF_PKT_MAX_SIZE)
+                size = CHIF_PKT_MAX_SIZE;
+            if (size < (int)(sizeof(struct ChifPktHeader) + sizeof(uint32_t))) {
+                printf("SMBIOS: packet of %d bytes has no record count\n", size);
+                fclose(fptr);
+                return -1;
+            }
+            end = size - sizeof(struct ChifPktHeader);
+
+            // little endian uint32_t count, then uint16_t size and data per record
+            NumRecs = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+                      (uint32_t)p[3] << 24;
+            dbPrintf("Number of Records = %d\n", NumRecs);
             while (NumRecs--) {
-                RecSz = (uint16_t)buffer[i];
+                if (i + sizeof(uint16_t) > end) {
+                    printf("SMBIOS: record count runs past the packet\n");
+                    break;
+                }
+                RecSz = (uint16_t)(p[i] | p[i + 1] << 8);
                 dbPrintf("Record Size = %d/0x%X\n", RecSz, RecSz);
                 i += sizeof(uint16_t);
+                if (i + RecSz > end) {
+                    printf("SMBIOS: record of %d bytes runs past the packet\n", RecSz);
+                    break;
+                }
                 hexdump(&buffer[i], RecSz);
                 fwrite(&buffer[i], RecSz, 1, fptr);
                 smbios_data_record((void*)&buffer[i], (int)RecSz);   // add records to the in memory smbios db
@@ -0,0 +1,178 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#include "trace.hpp"
+#include "stats.hpp"
+
+struct chif_trace_rec {
+    std::atomic<uint64_t> seq;  // record number + 1 once complete, 0 while written
+    uint64_t ts_ns;
+    const char *fmt;
+    uint32_t nargs;
+    uint64_t args[CHIF_TRACE_ARGS];
+};
+
+bool gChifTrace = false;
+
+static struct chif_trace_rec ring[CHIF_TRACE_RING];
+static std::atomic<uint64_t> trace_head{0};     // next record number
+
+/* chif_trace_put()
+ *
+ * Claim the next record and fill it.  seq tells the reader whether the
+ * record it copied is complete and was not reused while it was copying.
+ */
+void chif_trace_put(const char *fmt, int nargs, const uint64_t *args)
+{
+    uint64_t n = trace_head.fetch_add(1, std::memory_order_relaxed);
+    struct chif_trace_rec *r = &ring[n & (CHIF_TRACE_RING - 1)];
+
+    r->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    r->ts_ns = stats_now_ns();
+    r->fmt = fmt;
+    r->nargs = nargs;
+    memcpy(r->args, args, nargs * sizeof(uint64_t));
+
+    r->seq.store(n + 1, std::memory_order_release);
+}
+
+/* copy of record n, false when it is incomplete or was overwritten */
+static bool chif_trace_get(uint64_t n, struct chif_trace_rec *out)
+{
+    struct chif_trace_rec *r = &ring[n & (CHIF_TRACE_RING - 1)];
+
+    if (r->seq.load(std::memory_order_acquire) != n + 1)
+        return false;
+
+    out->ts_ns = r->ts_ns;
+    out->fmt = r->fmt;
+    out->nargs = r->nargs < CHIF_TRACE_ARGS ? r->nargs : CHIF_TRACE_ARGS;
+    memcpy(out->args, r->args, sizeof(out->args));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return r->seq.load(std::memory_order_relaxed) == n + 1;
+}
+
+/* chif_trace_format()
+ *
+ * printf for recorded arguments: every conversion takes the next 64-bit
+ * argument, length modifiers in the format are ignored.
+ */
+static void chif_trace_format(FILE *fp, const struct chif_trace_rec *r)
+{
+    const char *f = r->fmt;
+    char spec[32];
+    uint32_t arg = 0;
+    size_t n;
+
+    while (*f) {
+        if (*f != '%') {
+            fputc(*f++, fp);
+            continue;
+        }
+        if (f[1] == '%') {
+            fputc('%', fp);
+            f += 2;
+            continue;
+        }
+
+        // flags, width and precision are kept, the length is replaced by ll
+        n = 0;
+        spec[n++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && n < sizeof(spec) - 4)
+            spec[n++] = *f++;
+        while (*f && strchr("hlzjtL", *f))
+            f++;
+        if (!*f)
+            break;
+
+        if (arg >= r->nargs) {
+            fputs("<?>", fp);
+        } else if (strchr("diouxX", *f)) {
+            spec[n++] = 'l';
+            spec[n++] = 'l';
+            spec[n++] = *f;
+            spec[n] = 0;
+            if (*f == 'd' || *f == 'i')
+                fprintf(fp, spec, (long long)r->args[arg]);
+            else
+                fprintf(fp, spec, (unsigned long long)r->args[arg]);
+        } else if (*f == 'c') {
+            fputc((int)r->args[arg], fp);
+        } else if (*f == 'p') {
+            fprintf(fp, "%p", (void *)(uintptr_t)r->args[arg]);
+        } else {
+            fprintf(fp, "<%%%c?>", *f);
+        }
+        arg++;
+        f++;
+    }
+}
+
+void chif_trace_dump(FILE *fp)
+{
+    struct chif_trace_rec r;
+    uint64_t head = trace_head.load(std::memory_order_acquire);
+    uint64_t n = head > CHIF_TRACE_RING ? head - CHIF_TRACE_RING : 0;
+    uint64_t skipped = 0;
+
+    fprintf(fp, "CHIF trace, %llu records since start or clear\n", (unsigned long long)head);
+    for (; n < head; n++) {
+        if (!chif_trace_get(n, &r)) {
+            skipped++;
+            continue;
+        }
+        fprintf(fp, "  %llu.%06llu ", (unsigned long long)(r.ts_ns / 1000000000ull),
+                (unsigned long long)(r.ts_ns % 1000000000ull / 1000));
+        chif_trace_format(fp, &r);
+        if (!*r.fmt || r.fmt[strlen(r.fmt) - 1] != '\n')
+            fputc('\n', fp);
+    }
+    if (skipped)
+        fprintf(fp, "  (%llu records overwritten while dumping)\n", (unsigned long long)skipped);
+    fflush(fp);
+}
+
+void chif_trace_clear(void)
+{
+    uint32_t i;
+
+    trace_head.store(0, std::memory_order_relaxed);
+    for (i = 0; i < CHIF_TRACE_RING; i++)
+        ring[i].seq.store(0, std::memory_order_relaxed);
+}
+
+void chif_trace_signal(int signo, int value, void *ctx)
+{
+    (void)signo;
+    (void)ctx;
+
+    chif_trace_dump(stdout);
+    if (value == 1) {
+        chif_trace_clear();
+        printf("CHIF trace cleared\n");
+    }
+}
@@ -0,0 +1,275 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+
+#include "chif.hpp"
+#include "transport.hpp"
+#include "capture.hpp"
+#include "misc.hpp"
+
+static void set_nonblock(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/* epoll refuses (EPERM) descriptors whose driver has no poll support */
+static bool fd_pollable(int fd)
+{
+    struct epoll_event ev;
+    int epfd, rc;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+        return false;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    rc = epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    close(epfd);
+    return rc == 0;
+}
+
+/* blocking reads from a device without poll support */
+static void dev_reader_thread(int dev_fd, int sock)
+{
+    uint8_t buf[CHIF_PKT_MAX_SIZE];
+    int n;
+
+    while (1) {
+        n = read(dev_fd, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+        if (send(sock, buf, n, 0) < 0)
+            break;
+    }
+    close(sock);
+}
+
+/* requests of a capture file, as fast as the channel takes them */
+static void file_reader_thread(FILE *fp, int sock)
+{
+    uint8_t buf[CHIF_PKT_MAX_SIZE];
+    struct chif_cap_rec rec;
+
+    while (capture_read(fp, &rec, buf) > 0) {
+        if (rec.dir != CHIF_CAP_REQ)
+            continue;
+        if (send(sock, buf, rec.len, 0) < 0)
+            break;
+    }
+    fclose(fp);
+    close(sock);
+}
+
+/* feed rx_fd from a reader thread through a socketpair */
+static int transport_feed(struct chif_transport *t, int *sock)
+{
+    int sv[2];
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+        printf("transport: socketpair failed: %s\n", strerror(errno));
+        return -1;
+    }
+    set_nonblock(sv[0]);
+    t->rx_fd = sv[0];
+    *sock = sv[1];
+    return 0;
+}
+
+static int transport_dev(struct chif_transport *t, const char *path)
+{
+    int sock;
+
+    t->dev_fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (t->dev_fd < 0) {
+        printf("Could not open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    t->rx_fd = t->tx_fd = t->dev_fd;
+    if (fd_pollable(t->dev_fd))
+        return 0;
+
+    dbPrintf("CHIF: %s does not support poll, using reader thread\n", path);
+    if (transport_feed(t, &sock) < 0)
+        return -1;
+    fcntl(t->dev_fd, F_SETFL, fcntl(t->dev_fd, F_GETFL) & ~O_NONBLOCK);
+    std::thread(dev_reader_thread, t->dev_fd, sock).detach();
+    return 0;
+}
+
+static int transport_unix(struct chif_transport *t, const char *path)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("transport: socket path too long: %s\n", path);
+        return -1;
+    }
+
+    t->dev_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (t->dev_fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(t->dev_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(t->dev_fd, 1) < 0) {
+        printf("transport: cannot listen on %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    t->reconnect = true;
+    printf("CHIF: listening on %s\n", path);
+    return 0;
+}
+
+static int transport_file(struct chif_transport *t, const char *path)
+{
+    FILE *fp;
+    int sock;
+
+    fp = capture_read_open(path);
+    if (!fp)
+        return -1;
+
+    t->tx_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (t->tx_fd < 0 || transport_feed(t, &sock) < 0) {
+        fclose(fp);
+        return -1;
+    }
+    std::thread(file_reader_thread, fp, sock).detach();
+    return 0;
+}
+
+int chif_transport_open(struct chif_transport *t, const char *spec)
+{
+    t->rx_fd = t->tx_fd = t->dev_fd = -1;
+    t->reconnect = false;
+
+    if (strncmp(spec, "unix:", 5) == 0) {
+        t->type = CHIF_TRANSPORT_UNIX;
+        return transport_unix(t, spec + 5);
+    }
+
+    if (strncmp(spec, "fd:", 3) == 0) {
+        t->type = CHIF_TRANSPORT_FD;
+        t->rx_fd = t->tx_fd = atoi(spec + 3);
+        if (fcntl(t->rx_fd, F_GETFD) < 0) {
+            printf("transport: %s is not an open descriptor\n", spec);
+            return -1;
+        }
+        set_nonblock(t->rx_fd);
+        return 0;
+    }
+
+    if (strncmp(spec, "file:", 5) == 0) {
+        t->type = CHIF_TRANSPORT_FILE;
+        return transport_file(t, spec + 5);
+    }
+
+    t->type = CHIF_TRANSPORT_DEV;
+    if (strncmp(spec, "dev:", 4) == 0)
+        spec += 4;
+    return transport_dev(t, spec);
+}
+
+int chif_transport_accept(struct chif_transport *t)
+{
+    int fd;
+
+    fd = accept4(t->dev_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    // one client at a time, a new connection replaces the old one
+    chif_transport_disconnect(t);
+    t->rx_fd = t->tx_fd = fd;
+    return 0;
+}
+
+void chif_transport_disconnect(struct chif_transport *t)
+{
+    if (t->rx_fd >= 0)
+        close(t->rx_fd);
+    t->rx_fd = t->tx_fd = -1;
+}
+
+void chif_transport_close(struct chif_transport *t)
+{
+    if (t->tx_fd >= 0 && t->tx_fd != t->rx_fd && t->tx_fd != t->dev_fd)
+        close(t->tx_fd);
+    if (t->rx_fd >= 0 && t->rx_fd != t->dev_fd)
+        close(t->rx_fd);
+    if (t->dev_fd >= 0)
+        close(t->dev_fd);
+    t->rx_fd = t->tx_fd = t->dev_fd = -1;
+}
+
+int chif_transport_connect(const char *spec)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strncmp(spec, "fd:", 3) == 0) {
+        fd = atoi(spec + 3);
+        if (fcntl(fd, F_GETFD) < 0) {
+            printf("transport: %s is not an open descriptor\n", spec);
+            return -1;
+        }
+        return fd;
+    }
+
+    if (strncmp(spec, "unix:", 5) != 0) {
+        printf("transport: cannot connect to %s, use unix:PATH or fd:N\n", spec);
+        return -1;
+    }
+    spec += 5;
+    if (strlen(spec) >= sizeof(addr.sun_path)) {
+        printf("transport: socket path too long: %s\n", spec);
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, spec);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        printf("transport: cannot connect to %s: %s\n", spec, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -19,6 +19,8 @@
 
 #include "triton.hpp"
 #include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "chif_reply.hpp"
 #include <sys/types.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -30,30 +32,26 @@
 int Triton_Response(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
+	Reply<> reply(recv, resp, recvPkt->header.command | 0x8000, TRITON_SERVICE_ID);
 
-	respPkt->header.pkt_size = sizeof(struct ChifPktHeader);
-	respPkt->header.sequence = recvPkt->header.sequence;
-	respPkt->header.command = recvPkt->header.command | 0x8000;
-	respPkt->header.service_id = TRITON_SERVICE_ID;
     printf("Triton command: %04x\n", recvPkt->header.command);
-    printf("Triton resp command: %04x\n", respPkt->header.command);
-	return respPkt->header.pkt_size;
+    printf("Triton resp command: %04x\n", recvPkt->header.command | 0x8000);
+	return reply.send();
 }
 
 
-int TritonHandler(void *recv, void *resp)
+/* other triton commands don't need a response */
+static int Triton_NoResponse(void *recv, void *resp)
 {
 	struct ChifPkt *recvPkt = (struct ChifPkt *)recv;
-//	struct ChifPkt *respPkt = (struct ChifPkt *)resp;
 
+	(void)resp;
 	printf("TritonHandler: command:0x%08x\n", recvPkt->header.command);
-
-	switch(recvPkt->header.command) {
-		case 0x06:
-				return Triton_Response(recv, resp);
-		default:
-			//other rom command doesn't need to response
-			return -5;
-	}
+	return -5;
 }
+
+static constexpr struct chif_cmd triton_cmds[] = {
+	CHIF_CMD(0x06, 0, void, CHIF_CMD_IDEMPOTENT, Triton_Response, "Triton Acknowledge"),
+};
+
+CHIF_SERVICE(triton_service, TRITON_SERVICE_ID, "triton", chif_key_command, triton_cmds, Triton_NoResponse);
@@ -85,7 +85,7 @@ UEFI_RC uefi_util_platdef_store(void)
     memset(platdef_tmp, 0, PLATDEF_UPDATE_BUF_SZ);
 
     dbPrintf("opening platdef file\n");
-    fptr = fopen(PLATDEF_DATA_FILE, "rb");
+    fptr = fopen(CHIF_PATH(PLATDEF_DATA_FILE), "rb");
     if (!fptr) {
         printf("PLATDEF: Failed to open rom.bin file\n");
         free(platdef_tmp);
@@ -0,0 +1,312 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "chif.hpp"
+#include "workpool.hpp"
+#include "reactor.hpp"
+#include "misc.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+
+struct job_queue {
+    struct chif_job *head;
+    struct chif_job *tail;
+};
+
+static void queue_push(struct job_queue *q, struct chif_job *job)
+{
+    job->next = NULL;
+    if (q->tail)
+        q->tail->next = job;
+    else
+        q->head = job;
+    q->tail = job;
+}
+
+static struct chif_job *queue_pop(struct job_queue *q)
+{
+    struct chif_job *job = q->head;
+
+    if (job) {
+        q->head = job->next;
+        if (!q->head)
+            q->tail = NULL;
+    }
+    return job;
+}
+
+static std::thread *workers;
+static int nworkers;
+static std::atomic<bool> stopping;
+
+static workpool_handler pool_handler;
+static workpool_done pool_done;
+static thread_local const struct chif_job *current_job;
+
+/* free jobs and per service accounting are only touched by the event loop */
+static struct chif_job *free_jobs;
+static int pending[256];
+
+/* submitted jobs and the lane each worker is currently running */
+static std::mutex run_lock;
+static std::condition_variable run_cv;
+static struct job_queue run_queue;
+static uint32_t *busy_lane;
+static bool *busy;
+
+/* finished jobs, filled by the workers and drained by the event loop */
+static std::mutex done_lock;
+static struct job_queue done_queue;
+static int done_fd = -1;
+
+/* take the oldest job whose lane is not already running on another worker */
+static struct chif_job *next_job(void)
+{
+    struct chif_job *job, *prev = NULL;
+    int i;
+
+    for (job = run_queue.head; job; prev = job, job = job->next) {
+        for (i = 0; i < nworkers; i++) {
+            if (busy[i] && busy_lane[i] == job->lane)
+                break;
+        }
+        if (i < nworkers)
+            continue;
+
+        if (prev)
+            prev->next = job->next;
+        else
+            run_queue.head = job->next;
+        if (run_queue.tail == job)
+            run_queue.tail = prev;
+        return job;
+    }
+    return NULL;
+}
+
+static void worker_main(int id)
+{
+    struct chif_job *job;
+    uint64_t one = 1;
+    uint64_t start;
+
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lk(run_lock);
+            run_cv.wait(lk, [&job] { return stopping || (job = next_job()); });
+            if (stopping)
+                return;
+            busy[id] = true;
+            busy_lane[id] = job->lane;
+        }
+
+        CHIF_TRACE("worker %d start lane 0x%06x", id, job->lane);
+        start = stats_now_ns();
+        current_job = job;
+        job->out_size = pool_handler(job->recv, job->resp, CHIF_PKT_MAX_SIZE);
+        current_job = NULL;
+        job->handler_ns = stats_now_ns() - start;
+        CHIF_TRACE("worker %d done lane 0x%06x size %d", id, job->lane, job->out_size);
+
+        // queued as done before the lane is released, so that the next job
+        // of the lane cannot complete ahead of this one
+        {
+            std::lock_guard<std::mutex> lk(done_lock);
+            queue_push(&done_queue, job);
+        }
+        {
+            std::lock_guard<std::mutex> lk(run_lock);
+            busy[id] = false;
+        }
+        // a job held back behind this lane may now be runnable
+        run_cv.notify_all();
+
+        if (write(done_fd, &one, sizeof(one)) < 0)
+            dbPrintf("workpool: eventfd write failed: %s\n", strerror(errno));
+    }
+}
+
+/* workpool_reap()
+ *
+ * Hand every finished job to the completion callback and recycle it.
+ * Runs on the event loop.
+ */
+static void workpool_reap(void)
+{
+    struct job_queue finished;
+    struct chif_job *job;
+    struct ChifPkt *pkt;
+    uint64_t count;
+
+    if (read(done_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        dbPrintf("workpool: eventfd read failed: %s\n", strerror(errno));
+
+    {
+        std::lock_guard<std::mutex> lk(done_lock);
+        finished = done_queue;
+        done_queue.head = done_queue.tail = NULL;
+    }
+
+    while ((job = queue_pop(&finished))) {
+        pkt = (struct ChifPkt *)job->recv;
+        pending[pkt->header.service_id]--;
+        pool_done(job);
+        job->next = free_jobs;
+        free_jobs = job;
+    }
+}
+
+static void workpool_ready(int fd, uint32_t events, void *ctx)
+{
+    (void)fd;
+    (void)events;
+    (void)ctx;
+
+    workpool_reap();
+}
+
+int workpool_init(int count, workpool_handler handler, workpool_done done)
+{
+    struct chif_job *jobs;
+    int i;
+
+    done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (done_fd < 0) {
+        printf("workpool: eventfd failed: %s\n", strerror(errno));
+        return -1;
+    }
+    if (reactor_add_fd(done_fd, EPOLLIN, workpool_ready, NULL) < 0) {
+        close(done_fd);
+        done_fd = -1;
+        return -1;
+    }
+
+    jobs = new struct chif_job[WORKPOOL_JOBS];
+    for (i = 0; i < WORKPOOL_JOBS; i++) {
+        jobs[i].next = free_jobs;
+        free_jobs = &jobs[i];
+    }
+
+    pool_handler = handler;
+    pool_done = done;
+    nworkers = count;
+    busy = new bool[nworkers]();
+    busy_lane = new uint32_t[nworkers]();
+    workers = new std::thread[nworkers];
+    for (i = 0; i < nworkers; i++) {
+        workers[i] = std::thread(worker_main, i);
+    }
+
+    dbPrintf("workpool: %d workers, %d jobs\n", nworkers, WORKPOOL_JOBS);
+    return 0;
+}
+
+const struct chif_job *workpool_current(void)
+{
+    return current_job;
+}
+
+int workpool_submit(const void *recv, int in_size, uint32_t lane, int i2c_bus)
+{
+    struct chif_job *job;
+    struct pollfd pfd;
+
+    // Every buffer is busy: wait for a completion rather than growing.
+    while (!free_jobs) {
+        pfd.fd = done_fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+            return -1;
+        workpool_reap();
+    }
+
+    job = free_jobs;
+    free_jobs = job->next;
+
+    memcpy(job->recv, recv, in_size);
+    job->in_size = in_size;
+    job->out_size = 0;
+    job->handler_ns = 0;
+    job->lane = lane;
+    job->i2c_bus = i2c_bus;
+    pending[((struct ChifPkt *)job->recv)->header.service_id]++;
+
+    {
+        std::lock_guard<std::mutex> lk(run_lock);
+        queue_push(&run_queue, job);
+    }
+    run_cv.notify_one();
+    return 0;
+}
+
+int workpool_pending(uint8_t service_id)
+{
+    return pending[service_id];
+}
+
+void workpool_drain(void)
+{
+    struct pollfd pfd;
+    int i, outstanding;
+
+    while (1) {
+        outstanding = 0;
+        for (i = 0; i < 256; i++)
+            outstanding += pending[i];
+        if (!outstanding || done_fd < 0)
+            return;
+
+        pfd.fd = done_fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+            return;
+        workpool_reap();
+    }
+}
+
+void workpool_shutdown(void)
+{
+    int i;
+
+    if (!workers)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(run_lock);
+        stopping = true;
+    }
+    run_cv.notify_all();
+    for (i = 0; i < nworkers; i++) {
+        workers[i].join();
+    }
+    delete[] workers;
+    workers = NULL;
+}
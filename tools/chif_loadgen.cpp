@@ -0,0 +1,593 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  chif_loadgen
+*     Play the BIOS side of the CHIF channel against a running daemon
+*     (chif -offline -t unix:PATH) and measure how fast it answers.
+*
+*     chif_loadgen [-r RATE | -c N] [-d SEC] [-m MIX] [-n RECS] [-b EVS]
+*                  [-T MS] [-s SEED] unix:PATH|fd:N
+*        -r RATE  open loop: send RATE packets per second whatever the
+*                 daemon does; latency counts from the time a packet was due
+*        -c N     closed loop: keep N packets outstanding (default 1)
+*        -d SEC   how long to send (default 10)
+*        -m MIX   weights of the traffic classes (default
+*                 smif=50,ev=20,rom=10,platdef=20)
+*        -n RECS  SMBIOS records per upload (default 400)
+*        -b EVS   EV sets per EV burst (default 16)
+*        -T MS    a packet not answered within MS is lost (default 1000)
+*        -s SEED  seed of the class selection (default 1)
+*
+*     Traffic classes.  A class is drawn by weight and its packets are
+*     sent back to back before the next draw:
+*        smif     one SMIF query without payload (0x0002, 0x0050, ...)
+*        ev       EVS x 0x012c EV set, then one 0x0130 EV read
+*        rom      SMBIOS upload: ROM 0x03 begin, 0x0c blobs carrying RECS
+*                 records, 0x05 end
+*        platdef  0x0200 op 9 (specific records) and op 0xB (by type)
+*
+*     Reports sent/answered/lost and p50/p99/p999/max latency per class.
+*     Raise -r until the answered rate stops following it to find the
+*     saturation point of the channel.
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "transport.hpp"
+#include "stats.hpp"
+#include "ev.hpp"
+#include "platdef_api.hpp"
+
+#define LG_EV_NAMES         16
+#define LG_EV_SIZE          64
+#define LG_SMBIOS_REC_SIZE  24
+#define LG_SMBIOS_BLOB_RECS 127     // Rom_SmbiosRecords() reads the count from one byte
+#define LG_PLATDEF_RECS     16
+
+enum {
+    LG_SMIF = 0,
+    LG_EV,
+    LG_ROM,
+    LG_PLATDEF,
+    LG_CLASSES
+};
+
+struct lg_class {
+    const char *name;
+    unsigned weight;
+    uint64_t sent;
+    uint64_t answered;
+    uint64_t lost;
+    std::vector<uint64_t> lat_ns;
+};
+
+struct lg_pkt {
+    int cls;
+    std::vector<uint8_t> data;
+};
+
+struct lg_inflight {
+    bool used;
+    uint8_t cls;
+    uint64_t due_ns;
+};
+
+static struct lg_class classes[LG_CLASSES] = {
+    { "smif", 50, 0, 0, 0, {} },
+    { "ev", 20, 0, 0, 0, {} },
+    { "rom", 10, 0, 0, 0, {} },
+    { "platdef", 20, 0, 0, 0, {} },
+};
+
+static int sock = -1;
+static unsigned smbios_recs = 400;
+static unsigned ev_burst = 16;
+static uint64_t timeout_ns = 1000 * 1000000ull;
+
+static std::deque<struct lg_pkt> script;        // packets of the current draw
+static struct lg_inflight inflight[65536];      // by sequence
+static std::deque<uint16_t> inflight_order;     // sequences, oldest first
+static uint32_t ninflight;
+static uint16_t next_seq;
+static uint64_t stray, send_full, behind;
+
+/*
+ * Request builders, host side layout of the packets
+ */
+struct lg_012c {
+    uint8_t flags;
+    uint8_t rsvd[3];
+    char name[EV_NAME_MAX_LEN];
+    uint16_t sz_ev;
+    uint8_t buf[LG_EV_SIZE];
+} __attribute__ ((packed));
+
+struct lg_0200 {
+    uint32_t ErrorCode;
+    uint16_t op;
+    uint16_t flags;
+    uint32_t data_size;
+    uint32_t data_offset;
+    uint32_t timestamp;
+    uint16_t recordID;
+    uint16_t count;
+    PlatDefDataRequest req[LG_PLATDEF_RECS];
+} __attribute__ ((packed));
+
+static void script_add(int cls, uint8_t service_id, uint16_t command, const void *msg, uint16_t len)
+{
+    struct lg_pkt p;
+    struct ChifPkt *pkt;
+
+    p.cls = cls;
+    p.data.resize(sizeof(struct ChifPktHeader) + len);
+    pkt = (struct ChifPkt *)p.data.data();
+    pkt->header.pkt_size = p.data.size();
+    pkt->header.command = command;
+    pkt->header.service_id = service_id;
+    pkt->header.version = 0;
+    if (len)
+        memcpy(pkt->msg, msg, len);
+    script.push_back(std::move(p));
+}
+
+/* SMIF commands that take no payload and have no side effects */
+static const std::vector<uint16_t> &smif_cmds(void)
+{
+    static std::vector<uint16_t> cmds;
+    static bool done;
+    const struct chif_service *svc = &smif_service;
+    uint16_t k;
+
+    if (!done) {
+        for (k = 0; k < svc->span; k++) {
+            const struct chif_cmd *cmd;
+
+            if (!svc->index[k])
+                continue;
+            cmd = &svc->cmds[svc->index[k] - 1];
+            if ((cmd->flags & CHIF_CMD_IDEMPOTENT) && !(cmd->flags & CHIF_CMD_OFFLOAD) &&
+                cmd->req_size == 0)
+                cmds.push_back(cmd->command);
+        }
+        done = true;
+    }
+    return cmds;
+}
+
+/* only drawn with a weight, which main() drops when there is nothing to send */
+static void script_smif(void)
+{
+    const std::vector<uint16_t> &cmds = smif_cmds();
+    static size_t next;
+
+    if (cmds.empty())
+        return;
+    script_add(LG_SMIF, SMIF_SERVICE_ID, cmds[next++ % cmds.size()], NULL, 0);
+}
+
+static void script_ev(void)
+{
+    static uint32_t gen;
+    struct lg_012c set;
+    char name[EV_NAME_MAX_LEN];
+    unsigned i;
+
+    for (i = 0; i < ev_burst; i++) {
+        memset(&set, 0, sizeof(set));
+        set.flags = 0x01;
+        snprintf(set.name, sizeof(set.name), "LOADGEN_EV_%02u", (gen + i) % LG_EV_NAMES);
+        set.sz_ev = sizeof(set.buf);
+        memset(set.buf, (gen + i) & 0xff, sizeof(set.buf));
+        script_add(LG_EV, SMIF_SERVICE_ID, 0x012c, &set, sizeof(set));
+    }
+
+    memset(name, 0, sizeof(name));
+    snprintf(name, sizeof(name), "LOADGEN_EV_%02u", gen % LG_EV_NAMES);
+    script_add(LG_EV, SMIF_SERVICE_ID, 0x0130, name, sizeof(name));
+    gen += ev_burst;
+}
+
+/* begin, as many filler records per 0x0c blob as fit, end */
+static void script_rom(void)
+{
+    static uint8_t msg[CHIF_MSG_MAX_SIZE];
+    uint8_t rec[LG_SMBIOS_REC_SIZE + 2];
+    uint32_t n = 0;
+    size_t off = sizeof(uint32_t);
+    unsigned i;
+
+    script_add(LG_ROM, ROM_SERVICE_ID, 0x03, NULL, 0);
+
+    for (i = 0; i < smbios_recs; i++) {
+        if (off + 2 + sizeof(rec) > sizeof(msg) || n == LG_SMBIOS_BLOB_RECS) {
+            *(uint32_t *)msg = n;
+            script_add(LG_ROM, ROM_SERVICE_ID, 0x0c, msg, off);
+            off = sizeof(uint32_t);
+            n = 0;
+        }
+
+        // slot and OEM records with an empty string set
+        memset(rec, 0, sizeof(rec));
+        rec[0] = (i & 1) ? 9 : 216;
+        rec[1] = LG_SMBIOS_REC_SIZE;
+        *(uint16_t *)&rec[2] = 0x100 + i;
+        *(uint16_t *)&msg[off] = sizeof(rec);
+        memcpy(&msg[off + 2], rec, sizeof(rec));
+        off += 2 + sizeof(rec);
+        n++;
+    }
+    if (n) {
+        *(uint32_t *)msg = n;
+        script_add(LG_ROM, ROM_SERVICE_ID, 0x0c, msg, off);
+    }
+
+    script_add(LG_ROM, ROM_SERVICE_ID, 0x05, NULL, 0);
+}
+
+static void script_platdef(void)
+{
+    struct lg_0200 m;
+    int i;
+
+    memset(&m, 0, sizeof(m));
+    m.op = 0x0009;
+    m.data_size = 4000;
+    m.count = LG_PLATDEF_RECS;
+    for (i = 0; i < LG_PLATDEF_RECS; i++) {
+        m.req[i].RecordID = 2 + i;
+        m.req[i].Offset = 0;
+        m.req[i].length = 64;
+    }
+    script_add(LG_PLATDEF, SMIF_SERVICE_ID, 0x0200, &m, sizeof(m));
+
+    // all records of one type
+    memset(&m, 0, sizeof(m));
+    m.op = 0x000b;
+    m.data_size = 4000;
+    m.recordID = RecordType_TempSensor;
+    m.count = 0;
+    script_add(LG_PLATDEF, SMIF_SERVICE_ID, 0x0200, &m, sizeof(m));
+}
+
+/* next packet to send, drawing a new class when the script is done */
+static struct lg_pkt *next_pkt(void)
+{
+    unsigned total = 0, r;
+    int c;
+
+    if (!script.empty())
+        return &script.front();
+
+    for (c = 0; c < LG_CLASSES; c++)
+        total += classes[c].weight;
+    r = random() % total;
+    for (c = 0; c < LG_CLASSES - 1; c++) {
+        if (r < classes[c].weight)
+            break;
+        r -= classes[c].weight;
+    }
+
+    switch (c) {
+    case LG_SMIF:       script_smif(); break;
+    case LG_EV:         script_ev(); break;
+    case LG_ROM:        script_rom(); break;
+    case LG_PLATDEF:    script_platdef(); break;
+    }
+    return &script.front();
+}
+
+/* send_next()
+ *
+ * Send the next packet, accounting its latency from due_ns.  Returns 0,
+ * or -1 when the socket is full and the packet has to wait.
+ */
+static int send_next(uint64_t due_ns)
+{
+    struct lg_pkt *p = next_pkt();
+    struct ChifPkt *pkt = (struct ChifPkt *)p->data.data();
+    uint16_t seq;
+
+    if (ninflight >= 65536 - 1) {
+        return -1;
+    }
+    while (inflight[next_seq].used)
+        next_seq++;
+    seq = next_seq++;
+
+    pkt->header.sequence = seq;
+    if (send(sock, p->data.data(), p->data.size(), MSG_DONTWAIT) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+            send_full++;
+            return -1;
+        }
+        printf("chif_loadgen: send failed: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    inflight[seq].used = true;
+    inflight[seq].cls = p->cls;
+    inflight[seq].due_ns = due_ns;
+    inflight_order.push_back(seq);
+    ninflight++;
+    classes[p->cls].sent++;
+    script.pop_front();
+    return 0;
+}
+
+static void receive(void)
+{
+    static uint8_t buf[CHIF_PKT_MAX_SIZE];
+    struct ChifPkt *pkt = (struct ChifPkt *)buf;
+    struct lg_inflight *f;
+    int n;
+
+    while ((n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        if ((size_t)n < sizeof(struct ChifPktHeader) || !inflight[pkt->header.sequence].used) {
+            stray++;
+            continue;
+        }
+        f = &inflight[pkt->header.sequence];
+        classes[f->cls].answered++;
+        classes[f->cls].lat_ns.push_back(stats_now_ns() - f->due_ns);
+        f->used = false;
+        ninflight--;
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        printf("chif_loadgen: the daemon closed the channel\n");
+        exit(1);
+    }
+}
+
+/* forget packets older than the timeout */
+static void expire(uint64_t now)
+{
+    struct lg_inflight *f;
+
+    while (!inflight_order.empty()) {
+        f = &inflight[inflight_order.front()];
+        if (f->used) {
+            if (now - f->due_ns < timeout_ns)
+                break;
+            classes[f->cls].lost++;
+            f->used = false;
+            ninflight--;
+        }
+        inflight_order.pop_front();
+    }
+}
+
+static void wait_io(bool want_send, uint64_t until_ns)
+{
+    struct pollfd pfd;
+    struct timespec ts;
+    uint64_t now = stats_now_ns();
+    uint64_t wait = until_ns > now ? until_ns - now : 0;
+
+    pfd.fd = sock;
+    pfd.events = POLLIN | (want_send ? POLLOUT : 0);
+    ts.tv_sec = wait / 1000000000ull;
+    ts.tv_nsec = wait % 1000000000ull;
+    ppoll(&pfd, 1, &ts, NULL);
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &v, double q)
+{
+    size_t i = (size_t)(q * v.size());
+
+    return v[i < v.size() ? i : v.size() - 1];
+}
+
+static void report_line(const char *name, struct lg_class *c)
+{
+    std::vector<uint64_t> &v = c->lat_ns;
+
+    printf("  %-8s %10llu %10llu %8llu", name, (unsigned long long)c->sent,
+           (unsigned long long)c->answered, (unsigned long long)c->lost);
+    if (v.empty()) {
+        printf("\n");
+        return;
+    }
+    std::sort(v.begin(), v.end());
+    printf(" %10.1f %10.1f %10.1f %10.1f\n", percentile(v, 0.50) / 1e3, percentile(v, 0.99) / 1e3,
+           percentile(v, 0.999) / 1e3, v.back() / 1e3);
+}
+
+static int parse_mix(char *mix)
+{
+    char *tok, *save = NULL, *eq;
+    int c;
+
+    for (c = 0; c < LG_CLASSES; c++)
+        classes[c].weight = 0;
+
+    for (tok = strtok_r(mix, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        eq = strchr(tok, '=');
+        if (!eq)
+            return -1;
+        *eq = 0;
+        for (c = 0; c < LG_CLASSES; c++) {
+            if (strcmp(tok, classes[c].name) == 0)
+                break;
+        }
+        if (c == LG_CLASSES)
+            return -1;
+        classes[c].weight = strtoul(eq + 1, NULL, 0);
+    }
+
+    for (c = 0; c < LG_CLASSES; c++) {
+        if (classes[c].weight)
+            return 0;
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *spec = NULL;
+    struct lg_class all = { "all", 0, 0, 0, 0, {} };
+    double rate = 0, secs = 10;
+    unsigned conc = 1, seed = 1;
+    uint64_t start, end, now, due, period = 0;
+    bool blocked;
+    int i, c;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            rate = strtod(argv[++i], NULL);
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            conc = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            secs = strtod(argv[++i], NULL);
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            if (parse_mix(argv[++i]) < 0) {
+                spec = NULL;
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            smbios_recs = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            ev_burst = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc)
+            timeout_ns = strtoull(argv[++i], NULL, 0) * 1000000ull;
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            seed = strtoul(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-' && !spec)
+            spec = argv[i];
+        else {
+            spec = NULL;
+            break;
+        }
+    }
+    if (!spec || rate < 0 || !conc || secs <= 0) {
+        printf("usage: %s [-r RATE | -c N] [-d SEC] [-m smif=W,ev=W,rom=W,platdef=W] [-n RECS]\n"
+               "       [-b EVS] [-T MS] [-s SEED] unix:PATH|fd:N\n", argv[0]);
+        return 1;
+    }
+
+    if (classes[LG_SMIF].weight && smif_cmds().empty()) {
+        printf("chif_loadgen: no SMIF command qualifies, leaving smif out of the mix\n");
+        classes[LG_SMIF].weight = 0;
+        for (c = 0; c < LG_CLASSES && !classes[c].weight; c++)
+            ;
+        if (c == LG_CLASSES)
+            return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    sock = chif_transport_connect(spec);
+    if (sock < 0)
+        return 1;
+    srandom(seed);
+    next_seq = random();
+
+    if (rate > 0) {
+        period = (uint64_t)(1e9 / rate);
+        printf("chif_loadgen: open loop, %.0f packets/s for %.1f s\n", rate, secs);
+    } else {
+        printf("chif_loadgen: closed loop, %u outstanding for %.1f s\n", conc, secs);
+    }
+
+    start = stats_now_ns();
+    end = start + (uint64_t)(secs * 1e9);
+    due = start;
+
+    while (1) {
+        now = stats_now_ns();
+        blocked = false;
+
+        if (now < end) {
+            if (period) {
+                // everything that is due, late packets keep their due time
+                while (due <= now && due < end) {
+                    if (send_next(due) < 0) {
+                        blocked = true;
+                        break;
+                    }
+                    if (now - due > period)
+                        behind++;
+                    due += period;
+                }
+            } else {
+                while (ninflight < conc) {
+                    if (send_next(stats_now_ns()) < 0) {
+                        blocked = true;
+                        break;
+                    }
+                }
+            }
+        } else if (!ninflight) {
+            break;
+        }
+
+        receive();
+        now = stats_now_ns();
+        expire(now);
+
+        if (now >= end && !ninflight)
+            break;
+        if (!period && now < end && !blocked && ninflight < conc)
+            continue;           // answers came in, refill before waiting
+        if (period && now < end && !blocked)
+            wait_io(false, due < end ? due : end);
+        else
+            wait_io(blocked, now + 10000000ull);
+    }
+    now = stats_now_ns();
+
+    for (c = 0; c < LG_CLASSES; c++) {
+        all.sent += classes[c].sent;
+        all.answered += classes[c].answered;
+        all.lost += classes[c].lost;
+        all.lat_ns.insert(all.lat_ns.end(), classes[c].lat_ns.begin(), classes[c].lat_ns.end());
+    }
+
+    printf("\n%llu packets answered in %.3f s, %.1f/s", (unsigned long long)all.answered,
+           (now - start) / 1e9, all.answered / ((now - start) / 1e9));
+    if (period)
+        printf(", %llu sent late", (unsigned long long)behind);
+    printf(", socket full %llu times, %llu stray responses\n",
+           (unsigned long long)send_full, (unsigned long long)stray);
+    printf("  %-8s %10s %10s %8s %10s %10s %10s %10s\n", "class", "sent", "answered", "lost",
+           "p50 us", "p99 us", "p999 us", "max us");
+    for (c = 0; c < LG_CLASSES; c++) {
+        if (classes[c].sent)
+            report_line(classes[c].name, &classes[c]);
+    }
+    report_line(all.name, &all);
+
+    return all.lost ? 2 : 0;
+}
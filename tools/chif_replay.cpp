@@ -0,0 +1,269 @@
+/*
+// Copyright (c) 2026 Hewlett Packard Enterprise Development, LP
+//
+// Hewlett-Packard and the Hewlett-Packard logo are trademarks of
+// Hewlett-Packard Development Company, L.P. in the U.S. and/or other countries.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+/****************************************************************************
+*
+*  chif_replay
+*     Feed the requests of a capture (chif -rec FILE) through ChifHandler()
+*     in this process and compare every response with the recorded one.
+*
+*     chif_replay [-t] [-v] [-dbp] [-trace] CAPTURE
+*        -t      keep the recorded spacing between requests
+*        -v      print the differing bytes of mismatched responses
+*        -dbp    handler debug output
+*        -trace  trace the replay and dump the trace ring at the end
+*
+*     Reports per command: count, handler time of the replay, the latency
+*     the host saw when the capture was taken, and response mismatches.
+*
+*     The handlers write state files (evs.dat and the like), so $CHIF_ROOT
+*     must name a scratch directory other than /, and they run offline:
+*     no systemd or D-Bus calls.
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <vector>
+#include <map>
+
+#include "chif.hpp"
+#include "chif_dispatch.hpp"
+#include "capture.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "smif.hpp"
+#include "ev.hpp"
+#include "platdef_api.hpp"
+#include "i2c_mapping.hpp"
+#include "misc.hpp"
+
+extern bool gdbPrint;
+
+struct cap_pkt {
+    struct chif_cap_rec rec;
+    std::vector<uint8_t> data;
+    bool matched;
+};
+
+struct replay_stats {
+    const char *name;
+    uint64_t count;
+    uint64_t mismatches;
+    uint64_t missing;       // no recorded response to compare with
+    struct lat_hist replay;
+    struct lat_hist recorded;
+};
+
+static bool verbose;
+
+/* find the response the daemon sent for request 'req' */
+static struct cap_pkt *find_response(std::vector<struct cap_pkt> &pkts, size_t req)
+{
+    const struct ChifPkt *q = (const struct ChifPkt *)pkts[req].data.data();
+    size_t i;
+
+    for (i = req + 1; i < pkts.size(); i++) {
+        const struct ChifPkt *r = (const struct ChifPkt *)pkts[i].data.data();
+
+        if (pkts[i].matched || pkts[i].rec.len < sizeof(struct ChifPktHeader))
+            continue;
+        if (r->header.sequence != q->header.sequence ||
+            r->header.service_id != q->header.service_id)
+            continue;
+
+        // the same sequence reused by a later request: this one got no response
+        if (pkts[i].rec.dir == CHIF_CAP_REQ)
+            return NULL;
+
+        pkts[i].matched = true;
+        return &pkts[i];
+    }
+    return NULL;
+}
+
+static bool compare_response(const struct ChifPkt *req, const uint8_t *want, int want_len,
+                             const uint8_t *got, int got_len)
+{
+    int i, shown = 0;
+
+    if (want_len == got_len && memcmp(want, got, got_len) == 0)
+        return true;
+
+    if (!verbose)
+        return false;
+
+    printf("svc 0x%02x cmd 0x%04x seq 0x%04x: response differs, recorded %d bytes, replay %d bytes\n",
+           req->header.service_id, req->header.command, req->header.sequence, want_len, got_len);
+    for (i = 0; i < want_len && i < got_len && shown < 16; i++) {
+        if (want[i] != got[i]) {
+            printf("    +0x%04x: %02x -> %02x\n", i, want[i], got[i]);
+            shown++;
+        }
+    }
+    return false;
+}
+
+static void sleep_until(uint64_t deadline_ns)
+{
+    uint64_t now = stats_now_ns();
+    struct timespec ts;
+
+    if (deadline_ns <= now)
+        return;
+    ts.tv_sec = (deadline_ns - now) / 1000000000ull;
+    ts.tv_nsec = (deadline_ns - now) % 1000000000ull;
+    nanosleep(&ts, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t recv[CHIF_PKT_MAX_SIZE], resp[CHIF_PKT_MAX_SIZE];
+    std::vector<struct cap_pkt> pkts;
+    std::map<uint32_t, struct replay_stats> stats;
+    struct cap_pkt pkt, *match;
+    const char *path = NULL, *root;
+    char real[PATH_MAX];
+    const struct chif_cmd *cmd;
+    bool timing = false;
+    uint64_t start, t0, total_ns = 0;
+    uint64_t nreq = 0, nmismatch = 0;
+    FILE *fp;
+    int i, rc, out_size;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0)
+            timing = true;
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else if (strcmp(argv[i], "-dbp") == 0)
+            gdbPrint = true;
+        else if (strcmp(argv[i], "-trace") == 0)
+            gChifTrace = true;
+        else if (argv[i][0] != '-' && !path)
+            path = argv[i];
+        else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        printf("usage: %s [-t] [-v] [-dbp] [-trace] CAPTURE\n", argv[0]);
+        return 1;
+    }
+
+    // never replay into the state of a live BMC
+    root = getenv("CHIF_ROOT");
+    if (!root || !realpath(root, real) || strcmp(real, "/") == 0) {
+        printf("%s: set CHIF_ROOT to a scratch directory for the state files\n", argv[0]);
+        return 1;
+    }
+    gChifOffline = true;
+
+    fp = capture_read_open(path);
+    if (!fp)
+        return 1;
+
+    pkt.data.resize(CHIF_PKT_MAX_SIZE);
+    while ((rc = capture_read(fp, &pkt.rec, pkt.data.data())) > 0) {
+        struct cap_pkt p;
+
+        p.rec = pkt.rec;
+        p.data.assign(pkt.data.begin(), pkt.data.begin() + pkt.rec.len);
+        p.matched = false;
+        pkts.push_back(p);
+    }
+    fclose(fp);
+    if (rc < 0)
+        printf("%s: stopped at a damaged record, replaying what was read\n", path);
+
+    init_platdef();
+    load_i2c_mapping();
+    init_smif();
+    initEV();
+
+    start = stats_now_ns();
+    for (size_t n = 0; n < pkts.size(); n++) {
+        struct ChifPkt *req = (struct ChifPkt *)recv;
+        struct replay_stats *st;
+        uint32_t key;
+
+        if (pkts[n].rec.dir != CHIF_CAP_REQ || pkts[n].rec.len < sizeof(struct ChifPktHeader))
+            continue;
+
+        if (timing)
+            sleep_until(start + pkts[n].rec.ts_ns);
+
+        memset(recv, 0, sizeof(recv));
+        memcpy(recv, pkts[n].data.data(), pkts[n].rec.len);
+
+        cmd = chif_lookup(req);
+        key = ((uint32_t)req->header.service_id << 16) | (cmd ? cmd->command : req->header.command);
+        st = &stats[key];
+        if (!st->name)
+            st->name = cmd ? cmd->name : "unregistered";
+
+        CHIF_TRACE("rx svc 0x%02x cmd 0x%04x seq 0x%04x len %u", req->header.service_id,
+                   req->header.command, req->header.sequence, pkts[n].rec.len);
+        t0 = stats_now_ns();
+        out_size = ChifHandler(recv, resp, CHIF_PKT_MAX_SIZE);
+        t0 = stats_now_ns() - t0;
+        CHIF_TRACE("tx seq 0x%04x size %d handler %llu ns", req->header.sequence, out_size, t0);
+
+        st->count++;
+        nreq++;
+        total_ns += t0;
+        lat_hist_add(&st->replay, t0);
+
+        match = find_response(pkts, n);
+        if (!match) {
+            if (out_size > 0)
+                st->missing++;
+            continue;
+        }
+        lat_hist_add(&st->recorded, match->rec.ts_ns - pkts[n].rec.ts_ns);
+        if (!compare_response((struct ChifPkt *)pkts[n].data.data(), match->data.data(),
+                              match->rec.len, resp, out_size > 0 ? out_size : 0)) {
+            st->mismatches++;
+            nmismatch++;
+        }
+    }
+
+    printf("\n%llu requests replayed in %.3f ms of handler time, %llu responses differ\n",
+           (unsigned long long)nreq, total_ns / 1e6, (unsigned long long)nmismatch);
+    for (auto &it : stats) {
+        struct replay_stats *st = &it.second;
+
+        printf("  svc 0x%02x cmd 0x%04x %-40s count=%llu mismatches=%llu no_recorded_response=%llu\n",
+               it.first >> 16, it.first & 0xffff, st->name, (unsigned long long)st->count,
+               (unsigned long long)st->mismatches, (unsigned long long)st->missing);
+        lat_hist_print(stdout, "replay", &st->replay);
+        lat_hist_print(stdout, "recorded", &st->recorded);
+    }
+
+    if (gChifTrace)
+        chif_trace_dump(stdout);
+
+    closeEV();
+    return nmismatch ? 2 : 0;
+}